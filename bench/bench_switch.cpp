@@ -0,0 +1,484 @@
+/**
+ * @file   bench_switch.cpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ *
+ * Measures the cost of the context functions in cycles. The cycle counter is the DWT CYCCNT on Cortex-M3+,
+ * SysTick on ARMv6-M, rdtsc on x86-64, cntvct_el0 on AArch64 (that is the generic timer, not core cycles)
+ * and rdcycle on RISC-V.
+ *
+ * Every figure is the minimum over several runs divided by the iteration count.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <embo/coroutine.hpp>
+#include <embo/scheduler.hpp>
+#include <embo/batch.hpp>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#if defined(__linux__)
+#include <ucontext.h>
+#endif
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace
+{
+
+#if defined(__ARM_ARCH_PROFILE) && (__ARM_ARCH_PROFILE == 'M') && (__ARM_ARCH >= 7)
+
+volatile std::uint32_t & demcr      = *reinterpret_cast<volatile std::uint32_t*>(0xE000EDFCu);
+volatile std::uint32_t & dwt_ctrl   = *reinterpret_cast<volatile std::uint32_t*>(0xE0001000u);
+volatile std::uint32_t & dwt_cyccnt = *reinterpret_cast<volatile std::uint32_t*>(0xE0001004u);
+
+void init_cycles()
+{
+    demcr |= (1u << 24); //TRCENA
+    dwt_cyccnt = 0u;
+    dwt_ctrl  |= 1u;     //CYCCNTENA
+}
+
+inline std::uint32_t cycles() {return dwt_cyccnt;}
+inline std::uint32_t elapsed(std::uint32_t begin, std::uint32_t end) {return end - begin;}
+
+#elif defined(__ARM_ARCH_PROFILE) && (__ARM_ARCH_PROFILE == 'M')
+
+volatile std::uint32_t & syst_csr = *reinterpret_cast<volatile std::uint32_t*>(0xE000E010u);
+volatile std::uint32_t & syst_rvr = *reinterpret_cast<volatile std::uint32_t*>(0xE000E014u);
+volatile std::uint32_t & syst_cvr = *reinterpret_cast<volatile std::uint32_t*>(0xE000E018u);
+
+void init_cycles()
+{
+    syst_rvr = 0xFFFFFFu;
+    syst_cvr = 0u;
+    syst_csr = 0x5u; //processor clock, no interrupt, enabled
+}
+
+//systick counts down & is only 24 bit, so a single run must stay below 16M cycles.
+inline std::uint32_t cycles() {return syst_cvr;}
+inline std::uint32_t elapsed(std::uint32_t begin, std::uint32_t end) {return (begin - end) & 0xFFFFFFu;}
+
+#else
+
+void init_cycles() {}
+
+inline std::uint64_t cycles()
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t val;
+    __asm__ volatile ("isb; mrs %0, cntvct_el0" : "=r"(val));
+    return val;
+#elif defined(__riscv)
+    unsigned long val;
+    __asm__ volatile ("rdcycle %0" : "=r"(val));
+    return val;
+#else
+#error "No cycle counter for this target"
+#endif
+}
+
+inline std::uint64_t elapsed(std::uint64_t begin, std::uint64_t end) {return end - begin;}
+
+#endif
+
+constexpr std::size_t iterations = 1000u;
+constexpr std::size_t runs       = 10u;
+
+void report(const char * name, std::uint64_t total, std::size_t per = 1u)
+{
+    const auto ops = iterations * per;
+    std::printf("%-28s %8lu.%02lu cycles\n", name,
+                static_cast<unsigned long>(total / ops),
+                static_cast<unsigned long>((total % ops) * 100u / ops));
+}
+
+//runs func `runs` times and returns the minimal cycle count.
+template<typename Function>
+std::uint64_t measure(Function && func)
+{
+    std::uint64_t best = ~std::uint64_t();
+    for (std::size_t r = 0u; r < runs; r++)
+    {
+        const auto begin = cycles();
+        func();
+        const auto end = cycles();
+        best = std::min<std::uint64_t>(best, elapsed(begin, end));
+    }
+    return best;
+}
+
+__attribute__((noinline)) int f() {static volatile int i = 1; return i;}
+__attribute__((noinline)) int g() {static volatile int i = 2; return i;}
+__attribute__((noinline)) int h() {static volatile int i = 3; return i;}
+
+std::uint32_t stack[512];
+std::uint32_t fork_stack[512];
+
+void bench_spawn()
+{
+    auto total = measure([]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+            {
+                embo::coroutine<void()> cr{stack};
+                cr.spawn(+[](embo::yield_t<void()> yield_) {yield_();});
+            }
+        });
+    report("spawn", total);
+}
+
+void bench_void()
+{
+    embo::coroutine<void()> cr{stack};
+    cr.spawn(+[](embo::yield_t<void()> yield_) {while (true) yield_();});
+
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                cr.reenter();
+        });
+    report("void() reenter+yield", total);
+    report("void() switch", total, 2u);
+}
+
+void bench_inline()
+{
+    embo::coroutine<void(), embo::inline_context> cr{stack};
+    cr.spawn(+[](embo::yield_t<void(), embo::inline_context> yield_) {while (true) yield_();});
+
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                cr.reenter();
+        });
+    report("void() inline reenter+yield", total);
+    report("void() inline switch", total, 2u);
+}
+
+void bench_push_pull_32()
+{
+    embo::coroutine<std::int32_t(std::int32_t)> cr{stack};
+    cr.spawn([](embo::yield_t<std::int32_t(std::int32_t)> yield_)
+            {
+                std::int32_t val = 0;
+                while (true)
+                    val = yield_(val + 1);
+                return val;
+            });
+
+    volatile std::int32_t sink = 0;
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sink = cr.reenter(static_cast<std::int32_t>(i));
+        });
+    report("int32(int32) reenter+yield", total);
+    report("int32(int32) switch", total, 2u);
+}
+
+//the cost per value, pulling one value per switch compared to batches of 64.
+void bench_batch()
+{
+    embo::coroutine<std::int32_t()> single{stack};
+    single.spawn([](embo::yield_t<std::int32_t()> yield_)
+            {
+                std::int32_t val = 0;
+                while (true)
+                    yield_(val++);
+                return val;
+            });
+
+    volatile std::int32_t sink = 0;
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sink = single.reenter();
+        });
+    report("int32() per value", total);
+
+    std::int32_t buffer[64];
+    embo::batch_coroutine<std::int32_t> batched{fork_stack};
+    batched.spawn([](embo::batch_yield<std::int32_t> & yield_)
+            {
+                std::int32_t val = 0;
+                while (true)
+                    yield_(val++);
+            }, buffer);
+
+    total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+            {
+                const auto n = batched.reenter(buffer);
+                std::int32_t sum = 0;
+                for (std::size_t j = 0u; j < n; j++)
+                    sum += buffer[j];
+                sink = sum;
+            }
+        });
+    report("int32() per value, batch 64", total, 64u);
+}
+
+void bench_push_pull_64()
+{
+    embo::coroutine<std::int64_t(std::int64_t)> cr{stack};
+    cr.spawn([](embo::yield_t<std::int64_t(std::int64_t)> yield_)
+            {
+                std::int64_t val = 0;
+                while (true)
+                    val = yield_(val + 1);
+                return val;
+            });
+
+    volatile std::int64_t sink = 0;
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sink = cr.reenter(static_cast<std::int64_t>(i));
+        });
+    report("int64(int64) reenter+yield", total);
+    report("int64(int64) switch", total, 2u);
+}
+
+void bench_fork()
+{
+    embo::coroutine<void()> cr{stack};
+    cr.spawn(+[](embo::yield_t<void()> yield_)
+            {
+                volatile std::uint32_t buffer[32] = {};
+                while (true)
+                {
+                    buffer[0] = buffer[0] + 1u;
+                    yield_();
+                }
+            });
+
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+            {
+                embo::coroutine<void()> forked{fork_stack};
+                cr.fork(forked);
+            }
+        });
+    report("fork", total);
+}
+
+std::uint32_t task_stacks[2][512];
+
+//caller -> a -> b -> caller, compared to going through the caller in between.
+void bench_transfer()
+{
+    embo::coroutine<void()> a{task_stacks[0]}, b{task_stacks[1]};
+    b.spawn(+[](embo::yield_t<void()> yield_) {while (true) yield_();});
+    a.spawn([&](embo::yield_t<void()> yield_) {while (true) yield_.transfer_to(b);});
+
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                a.reenter();
+        });
+    report("transfer_to chain of 2", total);
+
+    embo::coroutine<void()> c{stack};
+    c.spawn(+[](embo::yield_t<void()> yield_) {while (true) yield_();});
+    total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+            {
+                b.reenter();
+                c.reenter();
+            }
+        });
+    report("caller chain of 2", total);
+}
+
+void bench_round_robin()
+{
+    embo::round_robin<> sched;
+    embo::task<> a{task_stacks[0]}, b{task_stacks[1]};
+    sched.spawn(a, +[](embo::yield_t<void()> yield_) {while (true) yield_();});
+    sched.spawn(b, +[](embo::yield_t<void()> yield_) {while (true) yield_();});
+
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sched.run_one();
+        });
+    report("round_robin dispatch", total);
+}
+
+void bench_priority()
+{
+    embo::priority_scheduler<> sched;
+    embo::task<> a{task_stacks[0]}, b{task_stacks[1]};
+    sched.spawn(a, 3u,  +[](embo::yield_t<void()> yield_) {while (true) yield_();});
+    sched.spawn(b, 17u, +[](embo::yield_t<void()> yield_) {while (true) yield_();});
+
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sched.run_one();
+        });
+    report("priority dispatch", total);
+}
+
+struct statemachine
+{
+    int state = 0;
+    bool done = false;
+    int operator()()
+    {
+        switch (state)
+        {
+            case 0:
+                state = 1; return f();
+            case 1:
+                state = 2; return g();
+            default:
+                state = 0; return h();
+        }
+    }
+};
+
+void bench_statemachine()
+{
+    statemachine sm;
+    volatile int sink = 0;
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sink = sm();
+        });
+    report("statemachine", total);
+
+    embo::coroutine<int()> cr{stack};
+    cr.spawn([](embo::yield_t<int()> yield_)
+            {
+                while (true)
+                {
+                    yield_(f());
+                    yield_(g());
+                    yield_(h());
+                }
+                return 0;
+            });
+    total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sink = cr.reenter();
+        });
+    report("coroutine statemachine", total);
+}
+
+#if defined(__cpp_impl_coroutine)
+
+struct stackless
+{
+    struct promise_type
+    {
+        int value = 0;
+        stackless get_return_object() {return stackless{std::coroutine_handle<promise_type>::from_promise(*this)};}
+        std::suspend_always initial_suspend() noexcept {return {};}
+        std::suspend_always final_suspend() noexcept {return {};}
+        std::suspend_always yield_value(int val) {value = val; return {};}
+        void return_void() {}
+        void unhandled_exception() {}
+    };
+
+    std::coroutine_handle<promise_type> handle;
+    explicit stackless(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    ~stackless() {handle.destroy();}
+
+    int operator()() {handle.resume(); return handle.promise().value;}
+};
+
+stackless stackless_statemachine()
+{
+    while (true)
+    {
+        co_yield f();
+        co_yield g();
+        co_yield h();
+    }
+}
+
+void bench_stackless()
+{
+    auto cr = stackless_statemachine();
+    volatile int sink = 0;
+    auto total = measure([&]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                sink = cr();
+        });
+    report("c++20 stackless", total);
+}
+
+#endif
+
+#if defined(__linux__)
+
+ucontext_t main_ctx, cr_ctx;
+
+void ucontext_func()
+{
+    while (true)
+        swapcontext(&cr_ctx, &main_ctx);
+}
+
+void bench_ucontext()
+{
+    getcontext(&cr_ctx);
+    cr_ctx.uc_stack.ss_sp   = stack;
+    cr_ctx.uc_stack.ss_size = sizeof(stack);
+    cr_ctx.uc_link = nullptr;
+    makecontext(&cr_ctx, &ucontext_func, 0);
+
+    auto total = measure([]
+        {
+            for (std::size_t i = 0u; i < iterations; i++)
+                swapcontext(&main_ctx, &cr_ctx);
+        });
+    report("ucontext reenter+yield", total);
+    report("ucontext switch", total, 2u);
+}
+
+#endif
+
+}
+
+int main()
+{
+    init_cycles();
+
+    bench_spawn();
+    bench_void();
+    bench_inline();
+    bench_push_pull_32();
+    bench_push_pull_64();
+    bench_batch();
+    bench_fork();
+    bench_transfer();
+    bench_round_robin();
+    bench_priority();
+    bench_statemachine();
+#if defined(__cpp_impl_coroutine)
+    bench_stackless();
+#endif
+#if defined(__linux__)
+    bench_ucontext();
+#endif
+    return 0;
+}
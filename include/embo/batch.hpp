@@ -0,0 +1,153 @@
+/**
+ * @file   embo/batch.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_BATCH_HPP_
+#define EMBO_BATCH_HPP_
+
+#include <embo/coroutine.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace embo
+{
+
+///The buffer the consumer hands to a batch_coroutine.
+template<typename T>
+struct batch_span
+{
+    T * data;
+    std::size_t size;
+};
+
+template<typename T, typename Context = default_context>
+class batch_coroutine;
+
+/**The yield handle of a batch_coroutine.
+ *
+ * The values are written into the buffer of the consumer, it only switches once the buffer is full.
+ */
+template<typename T, typename Context = default_context>
+class batch_yield
+{
+    typedef yield_t<std::size_t(batch_span<T>), Context> yield_type;
+
+    yield_type & _yield;
+    batch_span<T> _span;
+    std::size_t _pos = 0u;
+
+    batch_yield(yield_type & yield_, batch_span<T> span) : _yield(yield_), _span(span) {}
+
+    template<typename, typename>
+    friend class batch_coroutine;
+public:
+    batch_yield(const batch_yield & ) = delete;
+    batch_yield& operator=(const batch_yield & ) = delete;
+
+    void operator()(const T & value)
+    {
+        _span.data[_pos++] = value;
+        if (_pos == _span.size)
+            flush();
+    }
+
+    ///Copies count values, switching whenever the buffer runs full.
+    void write(const T * values, std::size_t count)
+    {
+        while (count > 0u)
+        {
+            const auto n = std::min(count, _span.size - _pos);
+            std::copy(values, values + n, _span.data + _pos);
+            values += n;
+            count  -= n;
+            _pos   += n;
+            if (_pos == _span.size)
+                flush();
+        }
+    }
+
+    ///Hands the values written so far to the consumer & waits for the next buffer.
+    void flush()
+    {
+        _span = _yield(_pos);
+        _pos  = 0u;
+    }
+
+    ///The number of values in the current buffer.
+    std::size_t size() const {return _pos;}
+};
+
+/**Coroutine producing values of type T in batches.
+ *
+ * The consumer passes a buffer with every resume & gets back the number of values written into it,
+ * so the switch cost is divided by the size of the buffer & the batch can be processed in a tight loop.
+ * The function has the signature `void(batch_yield<T, Context> &)`, when it returns the partial batch
+ * is handed over & the coroutine is exited. The buffers must not be empty.
+ *
+ * @code{.cpp}
+ * std::int32_t buffer[64];
+ * for (auto n = cr.spawn(producer, buffer); ; n = cr.reenter(buffer))
+ * {
+ *     consume(buffer, n);
+ *     if (cr.exited())
+ *         break;
+ * }
+ * @endcode
+ */
+template<typename T, typename Context>
+class batch_coroutine
+{
+    typedef coroutine<std::size_t(batch_span<T>), Context> coroutine_type;
+    coroutine_type _cr;
+
+    template<typename Function>
+    struct executor
+    {
+        Function func;
+        std::size_t operator()(yield_t<std::size_t(batch_span<T>), Context> yield_, batch_span<T> span)
+        {
+            batch_yield<T, Context> by{yield_, span};
+            func(by);
+            return by._pos;
+        }
+    };
+
+public:
+    typedef T value_type;
+
+    template<typename StackContainer>
+    batch_coroutine(StackContainer & sc) : _cr(sc) {}
+
+    template<typename U, std::size_t Size>
+    batch_coroutine(U(&sc)[Size]) : _cr(sc) {}
+
+    ///Starts the function, returns the number of values written into the first buffer.
+    template<typename Function>
+    std::size_t spawn(Function && func, T * data, std::size_t size)
+    {
+        typedef executor<typename std::decay<Function>::type> executor_type;
+        return _cr.spawn(executor_type{std::forward<Function>(func)}, batch_span<T>{data, size});
+    }
+
+    template<typename Function, std::size_t Size>
+    std::size_t spawn(Function && func, T(&buffer)[Size]) {return spawn(std::forward<Function>(func), buffer, Size);}
+
+    ///Resumes the producer with the next buffer, returns the number of values written into it.
+    std::size_t reenter(T * data, std::size_t size) {return _cr.reenter(batch_span<T>{data, size});}
+
+    template<std::size_t Size>
+    std::size_t reenter(T(&buffer)[Size]) {return reenter(buffer, Size);}
+
+    bool started() const {return _cr.started();}
+    bool  exited() const {return _cr.exited();}
+
+    std::size_t stack_size() const {return _cr.stack_size();}
+    std::size_t stack_used() const {return _cr.stack_used();}
+};
+
+}
+
+#endif /* EMBO_BATCH_HPP_ */
@@ -0,0 +1,279 @@
+/**
+ * @file   embo/channel.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_CHANNEL_HPP_
+#define EMBO_CHANNEL_HPP_
+
+#include <embo/scheduler.hpp>
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace embo
+{
+
+namespace detail
+{
+namespace coroutine
+{
+
+/**Fixed ring of N slots, the elements are constructed in place, so T needs no default constructor.
+ *
+ * The indices run modulo 2N instead of freely, so a full ring differs from an empty one for any N
+ * & no counter ever wraps around at a size that isn't a multiple of N.
+ */
+template<typename T, std::size_t N>
+class ring
+{
+    static_assert(N > 0u, "The channel needs at least one slot");
+
+    alignas(T) unsigned char _slots[N][sizeof(T)];
+public:
+    static std::size_t next(std::size_t index) {return (index + 1u == 2u * N) ? 0u : index + 1u;}
+    ///The number of elements between the two indices.
+    static std::size_t distance(std::size_t head, std::size_t tail) {return (tail >= head) ? (tail - head) : (tail + 2u * N - head);}
+
+    T * slot(std::size_t index) {return reinterpret_cast<T*>(_slots[(index < N) ? index : (index - N)]);}
+
+    void put(std::size_t index, T && value) {new (slot(index)) T(static_cast<T&&>(value));}
+
+    T take(std::size_t index)
+    {
+        auto p = slot(index);
+        T value(static_cast<T&&>(*p));
+        p->~T();
+        return value;
+    }
+};
+
+///The size of a cache line, to keep the indices of the producer & consumer apart.
+constexpr std::size_t cache_line = 64u;
+
+}
+}
+
+/**Bounded single-producer single-consumer channel between two tasks of a scheduler.
+ *
+ * The elements live in a ring of N slots inside the channel, so nothing is allocated.
+ * send & recv only suspend if the ring is full or empty respectively: the task gets blocked
+ * & the peer unblocks it with the next recv or send. Otherwise they don't switch at all,
+ * they only make a parked peer ready again.
+ *
+ * try_send & try_recv never suspend, so they can also be used from outside the tasks, e.g. the main loop.
+ * Like the scheduler the channel is not interrupt safe, concurrent_channel works across threads.
+ */
+template<typename T, std::size_t N, typename Scheduler = round_robin<>>
+class channel
+{
+    typedef typename Scheduler::task_type task_type;
+    typedef detail::coroutine::ring<T, N> ring_type;
+
+    Scheduler & _sched;
+    ring_type _ring;
+    std::size_t _head = 0u; //next to receive
+    std::size_t _tail = 0u; //next to send
+    task_type * _sender   = nullptr;
+    task_type * _receiver = nullptr;
+    bool _closed = false;
+
+    static void wake(Scheduler & sched, task_type *& parked)
+    {
+        if (parked)
+            sched.unblock(*parked);
+        parked = nullptr;
+    }
+
+public:
+    typedef T value_type;
+    typedef typename Scheduler::yield_type yield_type;
+
+    channel(Scheduler & sched) : _sched(sched) {}
+    channel(const channel & ) = delete;
+    channel& operator=(const channel & ) = delete;
+
+    ~channel()
+    {
+        for (; _head != _tail; _head = ring_type::next(_head))
+            _ring.take(_head);
+    }
+
+    ///Sends without suspending. Returns false if the channel is full or closed.
+    bool try_send(T value)
+    {
+        if (_closed || full())
+            return false;
+        _ring.put(_tail, static_cast<T&&>(value));
+        _tail = ring_type::next(_tail);
+        wake(_sched, _receiver);
+        return true;
+    }
+
+    ///Receives without suspending. Returns false if the channel is empty.
+    bool try_recv(T & value)
+    {
+        if (empty())
+            return false;
+        value = _ring.take(_head);
+        _head = ring_type::next(_head);
+        wake(_sched, _sender);
+        return true;
+    }
+
+    ///Sends the value, the current task is parked while the channel is full. Returns false if the channel got closed.
+    bool send(yield_type & yield_, T value)
+    {
+        while (!_closed && full())
+        {
+            _sender = _sched.current();
+            _sched.block(yield_);
+        }
+        return try_send(static_cast<T&&>(value));
+    }
+
+    ///Receives a value, the current task is parked while the channel is empty. Returns false if it is closed & drained.
+    bool recv(yield_type & yield_, T & value)
+    {
+        while (!_closed && empty())
+        {
+            _receiver = _sched.current();
+            _sched.block(yield_);
+        }
+        return try_recv(value);
+    }
+
+    ///Closes the channel, further sends fail, while the remaining values can still be received. Wakes up both sides.
+    void close()
+    {
+        _closed = true;
+        wake(_sched, _sender);
+        wake(_sched, _receiver);
+    }
+
+    bool closed() const {return _closed;}
+    bool empty()  const {return _head == _tail;}
+    bool full()   const {return size() == N;}
+    std::size_t size() const {return ring_type::distance(_head, _tail);}
+    constexpr static std::size_t capacity() {return N;}
+};
+
+/**Bounded single-producer single-consumer channel across threads, e.g. between the schedulers of two host threads.
+ *
+ * The indices of the producer & the consumer sit in their own cache lines & every side caches the index of the other one,
+ * so the cache lines only move when the cached view runs out. Since a scheduler can't be woken from another thread,
+ * a side that has to wait yields & retries, i.e. it stays ready in its own scheduler instead of being blocked.
+ * Any yield type works, so the sides can also be plain coroutines.
+ */
+template<typename T, std::size_t N>
+class concurrent_channel
+{
+    typedef detail::coroutine::ring<T, N> ring_type;
+
+    struct alignas(detail::coroutine::cache_line) producer
+    {
+        std::atomic<std::size_t> tail{0u};
+        std::size_t head_cache = 0u;
+    };
+
+    struct alignas(detail::coroutine::cache_line) consumer
+    {
+        std::atomic<std::size_t> head{0u};
+        std::size_t tail_cache = 0u;
+    };
+
+    producer _producer;
+    consumer _consumer;
+    alignas(detail::coroutine::cache_line) std::atomic<bool> _closed{false};
+    alignas(detail::coroutine::cache_line) ring_type _ring;
+
+    //only moves from the value if it got sent.
+    bool push(T & value)
+    {
+        const auto tail = _producer.tail.load(std::memory_order_relaxed);
+        if (ring_type::distance(_producer.head_cache, tail) == N)
+        {
+            _producer.head_cache = _consumer.head.load(std::memory_order_acquire);
+            if (ring_type::distance(_producer.head_cache, tail) == N)
+                return false;
+        }
+        _ring.put(tail, static_cast<T&&>(value));
+        _producer.tail.store(ring_type::next(tail), std::memory_order_release);
+        return true;
+    }
+
+public:
+    typedef T value_type;
+
+    concurrent_channel() = default;
+    concurrent_channel(const concurrent_channel & ) = delete;
+    concurrent_channel& operator=(const concurrent_channel & ) = delete;
+
+    ~concurrent_channel()
+    {
+        auto head = _consumer.head.load(std::memory_order_relaxed);
+        const auto tail = _producer.tail.load(std::memory_order_relaxed);
+        for (; head != tail; head = ring_type::next(head))
+            _ring.take(head);
+    }
+
+    ///Sends without suspending, only from the producer. Returns false if the channel is full or closed.
+    bool try_send(T value)
+    {
+        return !_closed.load(std::memory_order_relaxed) && push(value);
+    }
+
+    ///Receives without suspending, only from the consumer. Returns false if the channel is empty.
+    bool try_recv(T & value)
+    {
+        const auto head = _consumer.head.load(std::memory_order_relaxed);
+        if (head == _consumer.tail_cache)
+        {
+            _consumer.tail_cache = _producer.tail.load(std::memory_order_acquire);
+            if (head == _consumer.tail_cache)
+                return false;
+        }
+        value = _ring.take(head);
+        _consumer.head.store(ring_type::next(head), std::memory_order_release);
+        return true;
+    }
+
+    ///Sends the value, yielding while the channel is full. Returns false if the channel got closed.
+    template<typename Yield>
+    bool send(Yield & yield_, T value)
+    {
+        while (!_closed.load(std::memory_order_relaxed))
+        {
+            if (push(value))
+                return true;
+            yield_();
+        }
+        return false;
+    }
+
+    ///Receives a value, yielding while the channel is empty. Returns false if it is closed & drained.
+    template<typename Yield>
+    bool recv(Yield & yield_, T & value)
+    {
+        while (!try_recv(value))
+        {
+            //the values sent before the close are visible once it is, so a last try drains them.
+            if (_closed.load(std::memory_order_acquire))
+                return try_recv(value);
+            yield_();
+        }
+        return true;
+    }
+
+    ///Closes the channel, further sends fail, while the remaining values can still be received.
+    void close() {_closed.store(true, std::memory_order_release);}
+
+    bool closed() const {return _closed.load(std::memory_order_relaxed);}
+    constexpr static std::size_t capacity() {return N;}
+};
+
+}
+
+#endif /* EMBO_CHANNEL_HPP_ */
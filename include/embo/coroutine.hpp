@@ -12,6 +12,8 @@
 #include <cstdint>
 #include <type_traits>
 #include <algorithm>
+#include <cstring>
+#include <utility>
 
 namespace embo
 {
@@ -23,12 +25,50 @@ namespace coroutine
 
 struct impl
 {
-    std::uint32_t _stack_ptr;
+    std::uintptr_t _stack_ptr;
 
-    std::uint32_t _stack_begin;
-    std::uint32_t _stack_end;
+    std::uintptr_t _stack_begin;
+    std::uintptr_t _stack_end;
 };
 
+inline std::uintptr_t current_stack_ptr()
+{
+    std::uintptr_t stack_ptr;
+#if defined(__x86_64__)
+    __asm__ volatile ("mov %%rsp, %0" : "=r"(stack_ptr));
+#elif defined(__riscv)
+    __asm__ volatile ("mv %0, sp" : "=r"(stack_ptr));
+#else
+    __asm__ volatile ("mov %0, sp" : "=r"(stack_ptr));
+#endif
+    return stack_ptr;
+}
+
+/**Stack painting for the high water mark.
+ *
+ * The unused part of the stack gets filled with a pattern, the first word from the bottom
+ * that doesn't hold it anymore marks the peak usage. The scan is linear, because a large local
+ * that is only partially written leaves painted holes above the mark, which would mislead a binary search.
+ */
+constexpr std::uint32_t stack_paint = 0xA5A5A5A5u;
+
+inline void paint_stack(std::uintptr_t begin, std::uintptr_t end)
+{
+    auto itr = reinterpret_cast<std::uint32_t*>(begin);
+    const auto last = reinterpret_cast<std::uint32_t*>(end & ~static_cast<std::uintptr_t>(sizeof(std::uint32_t) - 1u));
+    while (itr < last)
+        *itr++ = stack_paint;
+}
+
+inline std::size_t stack_high_water(std::uintptr_t begin, std::uintptr_t end)
+{
+    auto itr = reinterpret_cast<const std::uint32_t*>(begin);
+    const auto last = reinterpret_cast<const std::uint32_t*>(end);
+    while ((itr < last) && (*itr == stack_paint))
+        itr++;
+    return end - reinterpret_cast<std::uintptr_t>(itr);
+}
+
 template<typename T>
 constexpr std::size_t size_of() {return sizeof(T);}
 
@@ -37,12 +77,154 @@ constexpr std::size_t size_of<void>() {return 0u;}
 
 
 
+#if defined(__aarch64__)
+///Integral values up to 128-bit can be passed in x0-x1.
+constexpr std::size_t max_integral_size = 16u;
+#else
+constexpr std::size_t max_integral_size = 8u;
+#endif
+
 template<typename T>
 using is_valid_type_t
     = std::integral_constant<bool,
          (size_of<T>() <= sizeof(std::uint32_t)) ||
-         ((std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value || std::is_reference<T>::value) && (sizeof(T) <= 8))
+         ((std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value || std::is_reference<T>::value) && (size_of<T>() <= max_integral_size))
+         >;
+
+#if defined(__arm__)
+///Trivially copyable values of up to 16 bytes, e.g. small records, are passed in a1-a4 on arm.
+template<typename T>
+using is_register_payload_t
+    = std::integral_constant<bool,
+         !std::is_reference<T>::value && std::is_trivially_copyable<T>::value &&
+         !is_valid_type_t<T>::value && (size_of<T>() <= 16u)
          >;
+#else
+template<typename T>
+using is_register_payload_t = std::false_type;
+#endif
+
+/**The integer word a small value gets bit-cast to.
+ *
+ * Only integers, enums & pointers are passed in the core registers the assembly uses, a float or a struct of floats
+ * would end up in a fp register (xmm0, s0 or v0), so these values are transported as an uint32_t.
+ */
+template<typename T, bool bit_cast = !(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) &&
+                                     (size_of<T>() <= sizeof(std::uint32_t))>
+struct register_word
+{
+    typedef T type;
+    static T to(T value) {return value;}
+    static T from(T value) {return value;}
+};
+
+template<typename T>
+struct register_word<T, true>
+{
+    typedef std::uint32_t type;
+
+    static std::uint32_t to(T value)
+    {
+        std::uint32_t w = 0u;
+        std::memcpy(&w, &value, sizeof(T));
+        return w;
+    }
+
+    static T from(std::uint32_t w)
+    {
+        T value;
+        std::memcpy(&value, &w, sizeof(T));
+        return value;
+    }
+};
+
+/**Decides how a value gets transported by the switch.
+ *
+ * Trivially copyable values that are valid types or register payloads are passed in registers, see register_word.
+ * Everything else is passed as a pointer to the object in the frame of the sender,
+ * which stays alive while the sender is suspended, so the receiver can move it out.
+ */
+template<typename T, bool in_register = !std::is_reference<T>::value && std::is_trivially_copyable<T>::value &&
+                                        (is_valid_type_t<T>::value || is_register_payload_t<T>::value)>
+struct transfer
+{
+    typedef typename register_word<T>::type type;
+    static type send(T & value) {return register_word<T>::to(value);}
+    static T receive(type value) {return register_word<T>::from(value);}
+};
+
+template<typename T>
+struct transfer<T, false>
+{
+    typedef T* type;
+    static T* send(T & value) {return &value;}
+    static T receive(T * value) {return static_cast<T&&>(*value);}
+};
+
+template<typename T>
+struct transfer<T&, false>
+{
+    typedef T* type;
+    static T* send(T & value) {return &value;}
+    static T& receive(T * value) {return *value;}
+};
+
+template<>
+struct transfer<void, false>
+{
+    typedef void type;
+};
+
+template<typename T>
+using transfer_t = typename transfer<T>::type;
+
+/**Hands a register payload of up to 8 bytes to the executor as an uint64_t in a3-a4.
+ *
+ * Taking the payload type itself, the executor would expect a double or a struct of floats in d0 / s0-s1
+ * under the hard-float abi, while the make functions leave the value in a3-a4.
+ */
+template<typename T>
+struct payload_word_transfer
+{
+    typedef std::uint64_t type;
+
+    static std::uint64_t send(T & value)
+    {
+        std::uint64_t w = 0u;
+        std::memcpy(&w, &value, sizeof(T));
+        return w;
+    }
+
+    static T receive(std::uint64_t w)
+    {
+        T value;
+        std::memcpy(&value, &w, sizeof(T));
+        return value;
+    }
+};
+
+///The initial value shares a1-a4 with the executor arguments, so payloads above 8 bytes are passed as a pointer.
+template<typename T>
+using make_transfer = typename std::conditional<is_register_payload_t<T>::value,
+                                                typename std::conditional<(size_of<T>() > 8u), transfer<T, false>, payload_word_transfer<T>>::type,
+                                                transfer<T>>::type;
+
+template<typename T>
+using make_transfer_t = typename make_transfer<T>::type;
+
+template<typename Return>
+struct receive_t
+{
+    template<typename Switch, typename ... Args>
+    static Return invoke(Args ... args) {return transfer<Return>::receive(Switch::invoke(args...));}
+};
+
+template<>
+struct receive_t<void>
+{
+    template<typename Switch, typename ... Args>
+    static void invoke(Args ... args) {Switch::invoke(args...);}
+};
 
 extern "C"
 {
@@ -55,230 +237,839 @@ std::uint32_t __embo_switch_context_0(impl * const);
 std::uint32_t __embo_switch_context_1(std::uint32_t, impl * const);
 std::uint32_t __embo_switch_context_2(std::uint64_t, impl * const);
 
+#if defined(__aarch64__)
+std::uint32_t __embo_make_context_3(impl * const, void * target, void * executor, unsigned __int128 value);
+std::uint32_t __embo_switch_context_3(unsigned __int128, impl * const);
+#endif
+
+#if defined(__arm__)
+//register payloads, only called through inline asm: the value is in a1-a4, the impl in ip.
+void __embo_make_context_4();
+void __embo_switch_context_4();
+#endif
+
+#if defined(__arm__) && defined(__ARM_FP)
+std::uint32_t __embo_make_context_fpu_0(impl * const, void * target, void * executor);
+std::uint32_t __embo_make_context_fpu_1(impl * const, void * target, void * executor, std::uint32_t  value);
+std::uint32_t __embo_make_context_fpu_2(impl * const, void * target, void * executor, std::uint64_t *value);
+
+std::uint32_t __embo_switch_context_fpu_0(impl * const);
+std::uint32_t __embo_switch_context_fpu_1(std::uint32_t, impl * const);
+std::uint32_t __embo_switch_context_fpu_2(std::uint64_t, impl * const);
+
+void __embo_make_context_fpu_4();
+void __embo_switch_context_fpu_4();
+#endif
+
 }
 
+///The default context, switching only the core registers.
+struct default_context
+{
+    static constexpr decltype(&__embo_make_context_0) make_context_0 = &__embo_make_context_0;
+    static constexpr decltype(&__embo_make_context_1) make_context_1 = &__embo_make_context_1;
+    static constexpr decltype(&__embo_make_context_2) make_context_2 = &__embo_make_context_2;
+
+    static constexpr decltype(&__embo_switch_context_0) switch_context_0 = &__embo_switch_context_0;
+    static constexpr decltype(&__embo_switch_context_1) switch_context_1 = &__embo_switch_context_1;
+    static constexpr decltype(&__embo_switch_context_2) switch_context_2 = &__embo_switch_context_2;
+#if defined(__aarch64__)
+    static constexpr decltype(&__embo_make_context_3)   make_context_3   = &__embo_make_context_3;
+    static constexpr decltype(&__embo_switch_context_3) switch_context_3 = &__embo_switch_context_3;
+#endif
+#if defined(__arm__)
+    static constexpr decltype(&__embo_make_context_4)   make_context_4   = &__embo_make_context_4;
+    static constexpr decltype(&__embo_switch_context_4) switch_context_4 = &__embo_switch_context_4;
+#endif
+};
+
+#if defined(__arm__) && defined(__ARM_FP)
+///The fpu context, additionally switching s16-s31 & the fpscr.
+struct fpu_context
+{
+    static constexpr decltype(&__embo_make_context_fpu_0) make_context_0 = &__embo_make_context_fpu_0;
+    static constexpr decltype(&__embo_make_context_fpu_1) make_context_1 = &__embo_make_context_fpu_1;
+    static constexpr decltype(&__embo_make_context_fpu_2) make_context_2 = &__embo_make_context_fpu_2;
+
+    static constexpr decltype(&__embo_switch_context_fpu_0) switch_context_0 = &__embo_switch_context_fpu_0;
+    static constexpr decltype(&__embo_switch_context_fpu_1) switch_context_1 = &__embo_switch_context_fpu_1;
+    static constexpr decltype(&__embo_switch_context_fpu_2) switch_context_2 = &__embo_switch_context_fpu_2;
+
+    static constexpr decltype(&__embo_make_context_fpu_4)   make_context_4   = &__embo_make_context_fpu_4;
+    static constexpr decltype(&__embo_switch_context_fpu_4) switch_context_4 = &__embo_switch_context_fpu_4;
+};
+#else
+///Without an arm fpu the callee-saved fp registers (if any) are already part of the default context.
+struct fpu_context : default_context {};
+#endif
 
-template<typename Return, typename PushType, bool large = (size_of<PushType>() > 4)>
+///Register payloads are up to 16 bytes, i.e. rax-rdx on x86-64 and a1-a4 on arm.
+struct words
+{
+    std::uintptr_t w[16u / sizeof(std::uintptr_t)];
+};
+
+template<typename T>
+struct word_cast
+{
+    static_assert(!std::is_reference<T>::value && (sizeof(T) <= sizeof(words)), "Only values of up to 16 bytes can be transported in registers");
+
+    static words to(T value)
+    {
+        words w{};
+        std::memcpy(&w, &value, sizeof(T));
+        return w;
+    }
+
+    static T from(words w)
+    {
+        T value;
+        std::memcpy(&value, &w, sizeof(T));
+        return value;
+    }
+};
+
+template<>
+struct word_cast<void>
+{
+    static void from(words) {}
+};
+
+#if defined(__x86_64__) || (defined(__thumb2__) && defined(__ARM_ARCH_PROFILE) && (__ARM_ARCH_PROFILE == 'M'))
+#define EMBO_COROUTINE_HAS_INLINE_CONTEXT 1
+#endif
+
+#if defined(EMBO_COROUTINE_HAS_INLINE_CONTEXT)
+/**The inline context switches through inline asm instead of calling the assembly functions.
+ *
+ * Instead of saving all callee-saved registers the asm declares them as clobbered,
+ * so the compiler only spills those live at the yield point & can inline the switch.
+ * The frame on the stack only holds the resume address & the frame registers the compiler may not clobber,
+ * hence both sides of a coroutine must use the inline context.
+ */
+struct inline_context {};
+
+#if defined(__x86_64__)
+
+#if defined(__AVX512F__)
+#define EMBO_COROUTINE_AVX512_CLOBBERS , "xmm16", "xmm17", "xmm18", "xmm19", "xmm20", "xmm21", "xmm22", "xmm23", \
+                                         "xmm24", "xmm25", "xmm26", "xmm27", "xmm28", "xmm29", "xmm30", "xmm31", \
+                                         "k1", "k2", "k3", "k4", "k5", "k6", "k7"
+#else
+#define EMBO_COROUTINE_AVX512_CLOBBERS
+#endif
+
+#define EMBO_COROUTINE_INLINE_CLOBBERS \
+    "rbx", "rcx", "rsi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",                \
+    "xmm0", "xmm1", "xmm2",  "xmm3",  "xmm4",  "xmm5",  "xmm6",  "xmm7",                       \
+    "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15",                      \
+    "st", "st(1)", "st(2)", "st(3)", "st(4)", "st(5)", "st(6)", "st(7)",                       \
+    "memory", "cc" EMBO_COROUTINE_AVX512_CLOBBERS
+
+//the red zone below rsp might be in use, so it gets skipped before pushing anything.
+inline words inline_switch(words w, impl * const ptr)
+{
+    register std::uintptr_t lo asm("rax") = w.w[0];
+    register std::uintptr_t hi asm("rdx") = w.w[1];
+    register impl * p asm("rdi") = ptr;
+    __asm__ volatile (
+            "lea -128(%%rsp), %%rsp\n\t"
+            "push %%rbp\n\t"
+            "lea 1f(%%rip), %%rcx\n\t"
+            "push %%rcx\n\t"             //the resume address
+            "mov %%rsp, %%rcx\n\t"
+            "mov (%%rdi), %%rsp\n\t"     //set the stack pointer
+            "mov %%rcx, (%%rdi)\n\t"     //store the old stack pointer
+            "ret\n"                      //resume the other side
+            "1:\n\t"
+            "pop %%rbp\n\t"
+            "lea 128(%%rsp), %%rsp\n\t"
+            : "+r"(lo), "+r"(hi), "+r"(p)
+            :
+            : EMBO_COROUTINE_INLINE_CLOBBERS);
+    return words{{lo, hi}};
+}
+
+inline words inline_make(impl * const ptr, void * target, void * executor, words w)
+{
+    register std::uintptr_t lo asm("rax");
+    register std::uintptr_t hi asm("rdx") = w.w[0]; //the third argument of the executor
+    register impl * p asm("rdi") = ptr;
+    register void * t asm("rsi") = target;
+    register void * e asm("r8")  = executor;
+    __asm__ volatile (
+            "lea -128(%%rsp), %%rsp\n\t"
+            "push %%rbp\n\t"
+            "lea 1f(%%rip), %%rcx\n\t"
+            "push %%rcx\n\t"
+            "mov %%rsp, %%rcx\n\t"
+            "mov (%%rdi), %%rsp\n\t"
+            "mov %%rcx, (%%rdi)\n\t"
+            "and $-16, %%rsp\n\t"        //align the stack like a call would
+            "xor %%ebp, %%ebp\n\t"
+            "push %%rbp\n\t"             //fake return address, the executor never returns
+            "jmp *%%r8\n"
+            "1:\n\t"
+            "pop %%rbp\n\t"
+            "lea 128(%%rsp), %%rsp\n\t"
+            : "=r"(lo), "+r"(hi), "+r"(p), "+r"(t), "+r"(e)
+            :
+            : "rbx", "rcx", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+              "xmm0", "xmm1", "xmm2",  "xmm3",  "xmm4",  "xmm5",  "xmm6",  "xmm7",
+              "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15",
+              "st", "st(1)", "st(2)", "st(3)", "st(4)", "st(5)", "st(6)", "st(7)",
+              "memory", "cc" EMBO_COROUTINE_AVX512_CLOBBERS);
+    return words{{lo, hi}};
+}
+
+#else
+
+#if defined(__ARM_FP)
+#define EMBO_COROUTINE_FP_CLOBBERS , \
+    "s0",  "s1",  "s2",  "s3",  "s4",  "s5",  "s6",  "s7",  "s8",  "s9",  "s10", "s11", "s12", "s13", "s14", "s15", \
+    "s16", "s17", "s18", "s19", "s20", "s21", "s22", "s23", "s24", "s25", "s26", "s27", "s28", "s29", "s30", "s31"
+#else
+#define EMBO_COROUTINE_FP_CLOBBERS
+#endif
+
+//r7 (the thumb frame pointer) & r9 (the platform register) might be reserved, so they are pushed manually.
+inline words inline_switch(words w, impl * const ptr)
+{
+    register std::uintptr_t a1 asm("r0") = w.w[0];
+    register std::uintptr_t a2 asm("r1") = w.w[1];
+    register std::uintptr_t a3 asm("r2") = w.w[2];
+    register std::uintptr_t a4 asm("r3") = w.w[3];
+    register impl * p asm("r12") = ptr;
+    __asm__ volatile (
+            "push {r7, r9}\n\t"
+            "adr lr, 1f\n\t"
+            "orr lr, lr, #1\n\t"         //stay in thumb mode
+            "push {lr}\n\t"              //the resume address
+            "mov lr, sp\n\t"
+            "ldr sp, [r12]\n\t"          //set the stack pointer
+            "str lr, [r12]\n\t"          //store the old stack pointer
+            "pop {pc}\n\t"               //resume the other side
+            ".align 2\n"
+            "1:\n\t"
+            "pop {r7, r9}\n\t"
+            : "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4), "+r"(p)
+            :
+            : "r4", "r5", "r6", "r8", "r10", "r11", "lr", "memory", "cc" EMBO_COROUTINE_FP_CLOBBERS);
+    return words{{a1, a2, a3, a4}};
+}
+
+inline words inline_make(impl * const ptr, void * target, void * executor, words w)
+{
+    register std::uintptr_t a1 asm("r0") = reinterpret_cast<std::uintptr_t>(ptr);
+    register std::uintptr_t a2 asm("r1") = reinterpret_cast<std::uintptr_t>(target);
+    register std::uintptr_t a3 asm("r2") = w.w[0];
+    register std::uintptr_t a4 asm("r3") = w.w[1];
+    register void * e asm("r12") = executor;
+    __asm__ volatile (
+            "push {r7, r9}\n\t"
+            "adr lr, 1f\n\t"
+            "orr lr, lr, #1\n\t"
+            "push {lr}\n\t"
+            "mov lr, sp\n\t"
+            "ldr sp, [r0]\n\t"
+            "str lr, [r0]\n\t"
+            "bx r12\n\t"                 //call the executor, it never returns
+            ".align 2\n"
+            "1:\n\t"
+            "pop {r7, r9}\n\t"
+            : "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4), "+r"(e)
+            :
+            : "r4", "r5", "r6", "r8", "r10", "r11", "lr", "memory", "cc" EMBO_COROUTINE_FP_CLOBBERS);
+    return words{{a1, a2, a3, a4}};
+}
+
+#endif
+
+template<typename Return, typename PushType>
+struct inline_make_context_t
+{
+    static Return invoke(impl * const ptr, void* target, void* executor, PushType value)
+    {
+        return word_cast<Return>::from(inline_make(ptr, target, executor, word_cast<PushType>::to(value)));
+    }
+};
+
+template<typename Return>
+struct inline_make_context_t<Return, void>
+{
+    static Return invoke(impl * const ptr, void * target, void * executor)
+    {
+        return word_cast<Return>::from(inline_make(ptr, target, executor, words{}));
+    }
+};
+
+template<typename Return, typename PushType>
+struct inline_switch_context_t
+{
+    static Return invoke(PushType value, impl * const ptr)
+    {
+        return word_cast<Return>::from(inline_switch(word_cast<PushType>::to(value), ptr));
+    }
+};
+
+template<typename Return>
+struct inline_switch_context_t<Return, void>
+{
+    static Return invoke(impl * const ptr)
+    {
+        return word_cast<Return>::from(inline_switch(words{}, ptr));
+    }
+};
+
+#else
+///No inline switch for this target, use the assembly functions.
+struct inline_context : default_context {};
+#endif
+
+#if defined(__arm__)
+
+#if defined(__ARM_FP)
+#define EMBO_COROUTINE_CALLER_FP_CLOBBERS , \
+    "s0",  "s1",  "s2",  "s3",  "s4",  "s5",  "s6",  "s7",  "s8",  "s9",  "s10", "s11", "s12", "s13", "s14", "s15"
+#else
+#define EMBO_COROUTINE_CALLER_FP_CLOBBERS
+#endif
+
+/*The payload functions keep a1-a4 untouched, so the asm calls them with the value in place.
+  Everything else behaves like a function call, i.e. the callee-saved registers are preserved.*/
+inline words payload_switch(void (*switch_context)(), words w, impl * const ptr)
+{
+    register std::uintptr_t a1 asm("r0") = w.w[0];
+    register std::uintptr_t a2 asm("r1") = w.w[1];
+    register std::uintptr_t a3 asm("r2") = w.w[2];
+    register std::uintptr_t a4 asm("r3") = w.w[3];
+    register impl * p asm("r12") = ptr;
+    __asm__ volatile (
+            "blx %[func]\n\t"
+            : "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4), "+r"(p)
+            : [func] "r"(switch_context)
+            : "lr", "memory", "cc" EMBO_COROUTINE_CALLER_FP_CLOBBERS);
+    return words{{a1, a2, a3, a4}};
+}
+
+inline words payload_make(void (*make_context)(), impl * const ptr, void * target, void * executor, words w)
+{
+    register std::uintptr_t a1 asm("r0") = reinterpret_cast<std::uintptr_t>(ptr);
+    register std::uintptr_t a2 asm("r1") = reinterpret_cast<std::uintptr_t>(target);
+    register std::uintptr_t a3 asm("r2") = w.w[0];
+    register std::uintptr_t a4 asm("r3") = w.w[1];
+    register void * e asm("r12") = executor;
+    __asm__ volatile (
+            "blx %[func]\n\t"
+            : "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4), "+r"(e)
+            : [func] "r"(make_context)
+            : "lr", "memory", "cc" EMBO_COROUTINE_CALLER_FP_CLOBBERS);
+    return words{{a1, a2, a3, a4}};
+}
+
+template<typename Context, typename Return, typename PushType>
+struct payload_make_context_t
+{
+    static Return invoke(impl * const ptr, void* target, void* executor, PushType value)
+    {
+        return word_cast<Return>::from(payload_make(Context::make_context_4, ptr, target, executor, word_cast<PushType>::to(value)));
+    }
+};
+
+template<typename Context, typename Return>
+struct payload_make_context_t<Context, Return, void>
+{
+    static Return invoke(impl * const ptr, void * target, void * executor)
+    {
+        return word_cast<Return>::from(payload_make(Context::make_context_4, ptr, target, executor, words{}));
+    }
+};
+
+template<typename Context, typename Return, typename PushType>
+struct payload_switch_context_t
+{
+    static Return invoke(PushType value, impl * const ptr)
+    {
+        return word_cast<Return>::from(payload_switch(Context::switch_context_4, word_cast<PushType>::to(value), ptr));
+    }
+};
+
+template<typename Context, typename Return>
+struct payload_switch_context_t<Context, Return, void>
+{
+    static Return invoke(impl * const ptr)
+    {
+        return word_cast<Return>::from(payload_switch(Context::switch_context_4, words{}, ptr));
+    }
+};
+
+#endif
+
+
+#if defined(EMBO_COROUTINE_HAS_INLINE_CONTEXT)
+template<typename Context>
+using is_inline_context_t = std::is_same<Context, inline_context>;
+#else
+template<typename Context>
+using is_inline_context_t = std::false_type;
+#endif
+
+enum class switch_path {plain, payload, inline_asm};
+
+/**Picks how the switch gets invoked, given the transported types.
+ *
+ * On arm register payloads use the payload functions in both directions, and so does make,
+ * if the initial value does not fit into a3 alone.
+ */
+template<typename Context, typename Return, typename PushType, bool make>
+constexpr switch_path select_path()
+{
+    return is_inline_context_t<Context>::value ? switch_path::inline_asm :
+           (is_register_payload_t<Return>::value || is_register_payload_t<PushType>::value
+#if defined(__arm__)
+            || (make && (size_of<PushType>() > 4u))
+#endif
+           ) ? switch_path::payload : switch_path::plain;
+}
+
+///Casts a context function to the signature of the transported types, going through void(*)() keeps -Wcast-function-type quiet.
+template<typename Func, typename Source>
+inline Func * function_cast(Source * func) {return reinterpret_cast<Func*>(reinterpret_cast<void(*)()>(func));}
+
+/**The casted context functions read the value from the core registers only (rdi, x0-x1, a1-a2, a0-a1).
+ *
+ * A float, double or homogeneous floating-point aggregate would be passed in the fp registers by the caller,
+ * so only integers, enums & pointers may appear in their signatures, see register_word.
+ */
+template<typename T>
+using is_core_register_t = std::integral_constant<bool,
+        std::is_void<T>::value || std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value>;
+
+template<typename Context, typename Return, typename PushType, bool large = (size_of<PushType>() > 4), bool wide = (size_of<PushType>() > 8)>
 struct make_context_t
 {
     static Return invoke(impl * const ptr, void* target, void* executor, PushType value)
     {
         using func_t = Return(impl * const, void *, void *, PushType);
-        auto make_context = reinterpret_cast<func_t*>(&__embo_make_context_1);
+        auto make_context = function_cast<func_t>(Context::make_context_1);
         return static_cast<Return>(make_context(ptr, target, executor, static_cast<PushType>(value)));
     }
 };
 
-template<typename Return, typename PushType>
-struct make_context_t<Return, PushType, true>
+template<typename Context, typename Return, typename PushType>
+struct make_context_t<Context, Return, PushType, true, false>
 {
     static Return invoke(impl * const ptr, void* target, void* executor, PushType value)
     {
         using func_t = Return(impl * const, void*, void*, PushType*);
-        auto make_context = reinterpret_cast<func_t*>(&__embo_make_context_2);
+        auto make_context = function_cast<func_t>(Context::make_context_2);
         return static_cast<Return>(make_context(ptr, target, executor, &value));
     }
 };
 
-template<typename Return>
-struct make_context_t<Return, void, false>
+#if defined(__aarch64__)
+template<typename Context, typename Return, typename PushType>
+struct make_context_t<Context, Return, PushType, true, true>
+{
+    static Return invoke(impl * const ptr, void* target, void* executor, PushType value)
+    {
+        using func_t = Return(impl * const, void*, void*, PushType);
+        auto make_context = function_cast<func_t>(Context::make_context_3);
+        return static_cast<Return>(make_context(ptr, target, executor, static_cast<PushType>(value)));
+    }
+};
+#endif
+
+template<typename Context, typename Return>
+struct make_context_t<Context, Return, void, false, false>
 {
     static Return invoke(impl * const ptr, void * target, void * executor)
     {
         using func_t = Return(impl * const, void*, void*);
-        auto make_context = reinterpret_cast<func_t*>(&__embo_make_context_0);
+        auto make_context = function_cast<func_t>(Context::make_context_0);
         return static_cast<Return>(make_context(ptr, target, executor));
     }
 };
 
-template<>
-struct make_context_t<void, void, false>
+template<typename Context>
+struct make_context_t<Context, void, void, false, false>
 {
     static void invoke(impl * const ptr, void * target, void * executor)
     {
         using func_t = void(impl * const, void*, void*);
-        auto make_context = reinterpret_cast<func_t*>(&__embo_make_context_0);
+        auto make_context = function_cast<func_t>(Context::make_context_0);
         make_context(ptr, target, executor);
     }
 };
 
-template<typename Return, typename PushType>
+template<typename Context, typename Return, typename PushType, switch_path = select_path<Context, Return, PushType, true>()>
+struct select_make_context
+{
+    static_assert(is_core_register_t<Return>::value && is_core_register_t<PushType>::value,
+                  "Only integers, enums & pointers can be passed to the context functions");
+    typedef make_context_t<Context, Return, PushType> type;
+};
+
+#if defined(EMBO_COROUTINE_HAS_INLINE_CONTEXT)
+template<typename Context, typename Return, typename PushType>
+struct select_make_context<Context, Return, PushType, switch_path::inline_asm>
+{
+    typedef inline_make_context_t<Return, PushType> type;
+};
+#endif
+
+#if defined(__arm__)
+template<typename Context, typename Return, typename PushType>
+struct select_make_context<Context, Return, PushType, switch_path::payload>
+{
+    typedef payload_make_context_t<Context, Return, PushType> type;
+};
+#endif
+
+template<typename Context, typename Return, typename PushType>
+using select_make_context_t = typename select_make_context<Context, Return, PushType>::type;
+
+template<typename Context, typename Return, typename PushType>
 inline Return make_context(impl * const this_, void* target, void * exec, PushType value)
 {
-    return static_cast<Return>(
-        make_context_t<Return, PushType>::invoke(this_, target, exec, static_cast<PushType>(value))
-            );
+    using make_t = select_make_context_t<Context, transfer_t<Return>, make_transfer_t<PushType>>;
+    return receive_t<Return>::template invoke<make_t>(this_, target, exec, make_transfer<PushType>::send(value));
 }
 
-template<typename Return>
+template<typename Context, typename Return>
 inline Return make_context(impl * const this_, void* target, void * exec)
 {
-    return static_cast<Return>(
-        make_context_t<Return, void>::invoke(this_, target, exec)
-            );
+    using make_t = select_make_context_t<Context, transfer_t<Return>, void>;
+    return receive_t<Return>::template invoke<make_t>(this_, target, exec);
 }
 
-template<>
-inline void make_context<void>(impl * const this_, void* target, void * exec)
-{
-    make_context_t<void, void>::invoke(this_, target, exec);
-}
 
 
 
-template<typename Return, typename PushType, bool large = (size_of<PushType>() > 4)>
+template<typename Context, typename Return, typename PushType, bool large = (size_of<PushType>() > 4), bool wide = (size_of<PushType>() > 8)>
 struct switch_context_t
 {
     static Return invoke(PushType value, impl * const ptr)
     {
         using func_t = Return(PushType, impl * const);
-        auto switch_context = reinterpret_cast<func_t*>(&__embo_switch_context_1);
+        auto switch_context = function_cast<func_t>(Context::switch_context_1);
         return static_cast<Return>(switch_context(static_cast<PushType>(value), ptr));
     }
 };
 
-template<typename Return, typename PushType>
-struct switch_context_t<Return, PushType, true>
+template<typename Context, typename Return, typename PushType>
+struct switch_context_t<Context, Return, PushType, true, false>
 {
     static Return invoke(PushType value, impl * const ptr)
     {
         using func_t = Return(PushType, impl * const);
-        auto switch_context = reinterpret_cast<func_t*>(&__embo_switch_context_2);
+        auto switch_context = function_cast<func_t>(Context::switch_context_2);
         return static_cast<Return>(switch_context(static_cast<PushType>(value), ptr));
     }
 };
 
-template<typename Return>
-struct switch_context_t<Return, void, false>
+#if defined(__aarch64__)
+template<typename Context, typename Return, typename PushType>
+struct switch_context_t<Context, Return, PushType, true, true>
+{
+    static Return invoke(PushType value, impl * const ptr)
+    {
+        using func_t = Return(PushType, impl * const);
+        auto switch_context = function_cast<func_t>(Context::switch_context_3);
+        return static_cast<Return>(switch_context(static_cast<PushType>(value), ptr));
+    }
+};
+#endif
+
+template<typename Context, typename Return>
+struct switch_context_t<Context, Return, void, false, false>
 {
     static Return invoke(impl * const ptr)
     {
         using func_t = Return(impl * const);
-        auto switch_context = reinterpret_cast<func_t*>(&__embo_switch_context_0);
+        auto switch_context = function_cast<func_t>(Context::switch_context_0);
         return static_cast<Return>(switch_context(ptr));
     }
 };
 
-template<typename Return, typename PushType>
+template<typename Context, typename Return, typename PushType, switch_path = select_path<Context, Return, PushType, false>()>
+struct select_switch_context
+{
+    static_assert(is_core_register_t<Return>::value && is_core_register_t<PushType>::value,
+                  "Only integers, enums & pointers can be passed to the context functions");
+    typedef switch_context_t<Context, Return, PushType> type;
+};
+
+#if defined(EMBO_COROUTINE_HAS_INLINE_CONTEXT)
+template<typename Context, typename Return, typename PushType>
+struct select_switch_context<Context, Return, PushType, switch_path::inline_asm>
+{
+    typedef inline_switch_context_t<Return, PushType> type;
+};
+#endif
+
+#if defined(__arm__)
+template<typename Context, typename Return, typename PushType>
+struct select_switch_context<Context, Return, PushType, switch_path::payload>
+{
+    typedef payload_switch_context_t<Context, Return, PushType> type;
+};
+#endif
+
+template<typename Context, typename Return, typename PushType>
+using select_switch_context_t = typename select_switch_context<Context, Return, PushType>::type;
+
+template<typename Context, typename Return, typename PushType>
 inline Return switch_context(PushType value, impl * const this_)
 {
-    return static_cast<Return>(
-        switch_context_t<Return, PushType>::invoke(static_cast<PushType>(value), this_)
-            );
+    using switch_t = select_switch_context_t<Context, transfer_t<Return>, transfer_t<PushType>>;
+    return receive_t<Return>::template invoke<switch_t>(transfer<PushType>::send(value), this_);
 }
 
-template<typename Return>
+template<typename Context, typename Return>
 inline Return switch_context(impl * const this_)
 {
-    return static_cast<Return>(
-        switch_context_t<Return, void>::invoke(this_)
-            );
+    using switch_t = select_switch_context_t<Context, transfer_t<Return>, void>;
+    return receive_t<Return>::template invoke<switch_t>(this_);
+}
+
+/**Where the saved frame pointer sits in the context frame of a suspended coroutine, -1 if the chain isn't walked.
+ *
+ * The frame records are standardized on x86-64, aarch64 & risc-v, but not on arm, where gcc & clang use different registers & layouts.
+ */
+#if defined(__x86_64__)
+template<typename Context>
+struct frame_pointer_slot : std::integral_constant<std::ptrdiff_t, 5 * sizeof(std::uintptr_t)> {}; //after r15-r12 & rbx
+template<>
+struct frame_pointer_slot<inline_context> : std::integral_constant<std::ptrdiff_t, sizeof(std::uintptr_t)> {}; //after the resume address
+///The previous frame pointer is stored at the frame pointer.
+constexpr std::ptrdiff_t frame_link_offset = 0;
+#elif defined(__aarch64__)
+template<typename Context>
+struct frame_pointer_slot : std::integral_constant<std::ptrdiff_t, 0x90> {};
+constexpr std::ptrdiff_t frame_link_offset = 0;
+#elif defined(__riscv)
+template<typename Context>
+struct frame_pointer_slot : std::integral_constant<std::ptrdiff_t, sizeof(std::uintptr_t)> {}; //s0, after ra
+///The frame pointer points to the canonical frame address, the previous one is stored below ra.
+constexpr std::ptrdiff_t frame_link_offset = -2 * static_cast<std::ptrdiff_t>(sizeof(std::uintptr_t));
+#else
+template<typename Context>
+struct frame_pointer_slot : std::integral_constant<std::ptrdiff_t, -1> {};
+constexpr std::ptrdiff_t frame_link_offset = 0;
+#endif
+
+/**Copies the live region of a suspended coroutine onto another stack & fixes the pointers the library knows about.
+ *
+ * That is the frame chain, starting at the saved frame pointer, & every word holding the address of the
+ * coroutine object, i.e. the yield handles & the arguments of the executor. The return addresses in the frame records
+ * point into the code and stay valid. Returns false if the live region doesn't fit into the target stack.
+ */
+inline bool fork_stack(const impl & from, impl & to, const void * from_self, void * to_self, std::ptrdiff_t fp_slot)
+{
+    const std::size_t used = from._stack_end - from._stack_ptr;
+    if (used > (to._stack_end - to._stack_begin))
+        return false;
+
+    to._stack_ptr = to._stack_end - used;
+    std::memcpy(reinterpret_cast<void*>(to._stack_ptr), reinterpret_cast<const void*>(from._stack_ptr), used);
+
+    const auto self = reinterpret_cast<std::uintptr_t>(from_self);
+    auto itr = reinterpret_cast<std::uintptr_t*>(to._stack_ptr);
+    const auto last = reinterpret_cast<std::uintptr_t*>(to._stack_ptr + (used & ~(sizeof(std::uintptr_t) - 1u)));
+    for (; itr < last; itr++)
+        if (*itr == self)
+            *itr = reinterpret_cast<std::uintptr_t>(to_self);
+
+    if (fp_slot < 0)
+        return true;
+
+    //the frames get older towards the end of the stack, so the chain has to go up, which also stops it at garbage.
+    const auto delta = to._stack_end - from._stack_end;
+    auto slot = to._stack_ptr + fp_slot;
+    std::uintptr_t fp = 0u;
+    while ((slot >= to._stack_ptr) && ((slot + sizeof(std::uintptr_t)) <= to._stack_end))
+    {
+        const auto next = *reinterpret_cast<std::uintptr_t*>(slot);
+        if ((next <= fp) || (next < from._stack_ptr) || (next >= from._stack_end))
+            break;
+        *reinterpret_cast<std::uintptr_t*>(slot) = next + delta;
+        fp   = next;
+        slot = next + delta + frame_link_offset;
+    }
+    return true;
 }
 
 }
 }
 
-template<typename T = void()>
+using ::embo::detail::coroutine::default_context;
+using ::embo::detail::coroutine::fpu_context;
+using ::embo::detail::coroutine::inline_context;
+
+/**The relocation of a fork, that gets passed to the relocate hook.
+ *
+ * It maps addresses in the live region of the parent onto the stack of the child,
+ * so the hook can find its objects in the child & rebase the pointers they hold.
+ */
+class fork_relocation
+{
+    std::uintptr_t _begin;
+    std::uintptr_t _end;
+    std::uintptr_t _target;
+public:
+    fork_relocation(std::uintptr_t begin, std::uintptr_t end, std::uintptr_t target) : _begin(begin), _end(end), _target(target) {}
+
+    ///If the address is in the live region of the parent.
+    bool contains(std::uintptr_t value) const {return (value >= _begin) && (value < _end);}
+
+    ///Rebases the value if it points into the live region of the parent, otherwise returns it unchanged.
+    std::uintptr_t rebase(std::uintptr_t value) const {return contains(value) ? value - _begin + _target : value;}
+
+    template<typename T>
+    T * operator()(T * ptr) const {return reinterpret_cast<T*>(rebase(reinterpret_cast<std::uintptr_t>(ptr)));}
+
+    ///The words of the live region of the child.
+    std::uintptr_t * begin() const {return reinterpret_cast<std::uintptr_t*>(_target);}
+    std::uintptr_t * end()   const {return reinterpret_cast<std::uintptr_t*>(_target + ((_end - _begin) & ~(sizeof(std::uintptr_t) - 1u)));}
+};
+
+///Relocate hook of fork, that leaves the pointers to locals alone.
+struct no_relocate
+{
+    void operator()(const fork_relocation & ) const {}
+};
+
+/**The default relocate hook of fork, that rebases every word of the child that points into the live region of the parent.
+ *
+ * This also catches the pointers to locals the compiler keeps in callee-saved registers or spill slots,
+ * at the price of rebasing integers, that happen to look like such an address.
+ */
+struct fork_rebase_all
+{
+    void operator()(const fork_relocation & r) const
+    {
+        for (auto & w : r)
+            w = r.rebase(w);
+    }
+};
+
+template<typename T = void(), typename Context = default_context>
 class coroutine;
 
 
 
-template<typename T = void()>
+template<typename T = void(), typename Context = default_context>
 class yield_t;
 
-template<typename Return, typename PushType>
-class yield_t<Return(PushType)>
+template<typename Return, typename PushType, typename Context>
+class yield_t<Return(PushType), Context>
 {
-    coroutine<Return(PushType)> *_cr;
-    yield_t(coroutine<Return(PushType)> * const ptr) : _cr(ptr) {}
+    coroutine<Return(PushType), Context> *_cr;
+    yield_t(coroutine<Return(PushType), Context> * const ptr) : _cr(ptr) {}
 public:
     yield_t(const yield_t & yt) = delete;
     yield_t operator=(const yield_t & yt) = delete;
     inline PushType operator()(Return rt);
 
+    /**Suspends this coroutine & resumes target directly, which must be suspended at a yield & not be part of the current chain.
+     *
+     * Target takes the place of this coroutine: when it yields or exits, the reenter that resumed this one returns with its value.
+     * This coroutine stays suspended in transfer_to, until it gets reentered.
+     */
+    inline PushType transfer_to(coroutine<Return(PushType), Context> & target, PushType pt);
 
-    inline std::uint32_t stack_ptr () const;
+    inline std::uintptr_t stack_ptr () const;
     inline std::size_t stack_size() const;
     inline std::size_t stack_used() const;
     inline std::size_t stack_left() const;
 
-    template<typename T>
+    template<typename, typename>
     friend class coroutine;
 };
 
-template<typename Return>
-class yield_t<Return()>
+template<typename Return, typename Context>
+class yield_t<Return(), Context>
 {
-    coroutine<Return()> *_cr;
-    yield_t(coroutine<Return()> * const ptr) : _cr(ptr) {}
+    coroutine<Return(), Context> *_cr;
+    yield_t(coroutine<Return(), Context> * const ptr) : _cr(ptr) {}
 public:
     yield_t(const yield_t & yt) = delete;
     yield_t operator=(const yield_t & yt) = delete;
     inline void operator()(Return rt);
 
-    inline std::uint32_t stack_ptr () const;
+    ///Suspends this coroutine & resumes target directly, see yield_t<Return(PushType)>::transfer_to.
+    inline void transfer_to(coroutine<Return(), Context> & target);
+
+    inline std::uintptr_t stack_ptr () const;
     inline std::size_t stack_size() const;
     inline std::size_t stack_used() const;
     inline std::size_t stack_left() const;
 
-    template<typename T>
+    template<typename, typename>
     friend class coroutine;
 };
 
-template<typename PushType>
-class yield_t<void(PushType)>
+template<typename PushType, typename Context>
+class yield_t<void(PushType), Context>
 {
-    coroutine<void(PushType)> *_cr;
-    yield_t(coroutine<void(PushType)> * const ptr) : _cr(ptr) {}
+    coroutine<void(PushType), Context> *_cr;
+    yield_t(coroutine<void(PushType), Context> * const ptr) : _cr(ptr) {}
 public:
     yield_t(const yield_t & yt) = delete;
     yield_t operator=(const yield_t & yt) = delete;
     inline PushType operator()();
 
-    inline std::uint32_t stack_ptr () const;
+    ///Suspends this coroutine & resumes target directly, see yield_t<Return(PushType)>::transfer_to.
+    inline PushType transfer_to(coroutine<void(PushType), Context> & target, PushType pt);
+
+    inline std::uintptr_t stack_ptr () const;
     inline std::size_t stack_size() const;
     inline std::size_t stack_used() const;
     inline std::size_t stack_left() const;
 
-    template<typename T>
+    template<typename, typename>
     friend class coroutine;
 };
 
-template<>
-class yield_t<void()>
+template<typename Context>
+class yield_t<void(), Context>
 {
-    coroutine<void()> *_cr;
-    yield_t(coroutine<void()> * const ptr) : _cr(ptr) {}
+    coroutine<void(), Context> *_cr;
+    yield_t(coroutine<void(), Context> * const ptr) : _cr(ptr) {}
 public:
     yield_t(const yield_t & yt) = delete;
     yield_t operator=(const yield_t & yt) = delete;
     inline void operator()();
 
-    inline std::uint32_t stack_ptr () const;
+    ///Suspends this coroutine & resumes target directly, see yield_t<Return(PushType)>::transfer_to.
+    inline void transfer_to(coroutine<void(), Context> & target);
+
+    inline std::uintptr_t stack_ptr () const;
     inline std::size_t stack_size() const;
     inline std::size_t stack_used() const;
     inline std::size_t stack_left() const;
 
-    template<typename T>
+    template<typename, typename>
     friend class coroutine;
 };
 
-template<typename Return, typename PushType>
-class coroutine<Return(PushType)> : ::embo::detail::coroutine::impl
+template<typename Return, typename PushType, typename Context>
+class coroutine<Return(PushType), Context> : ::embo::detail::coroutine::impl
 {
-    static_assert(embo::detail::coroutine::is_valid_type_t<Return>::value,   "The return type must either be a 64-bit integral type or a 32-bit compound type");
+    static_assert(std::is_move_constructible<Return>::value, "The return type must be move constructible");
 
     bool _started = false;
     bool _exited  = false;
 
-    template<typename T>
-    friend struct yield_t;
+    template<typename, typename>
+    friend class yield_t;
 
 public:
 
     typedef Return return_type;
     typedef PushType push_type;
-    typedef yield_t<Return()> yield_type;
+    typedef yield_t<Return(), Context> yield_type;
 
     template<typename StackContainer>
     coroutine(StackContainer & sc) : ::embo::detail::coroutine::impl(
@@ -288,7 +1079,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc.data() + sc.size())
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
     template<typename T, std::size_t Size>
     coroutine(T(&sc)[Size]) : ::embo::detail::coroutine::impl(
@@ -298,7 +1093,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc + Size)
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
     coroutine(const coroutine & cr) = delete;
     coroutine(coroutine && cr) = default;
@@ -307,23 +1106,39 @@ public:
     coroutine& operator=(coroutine && cr) = default;
 
 
-    template<typename StackContainer>
-    coroutine fork(StackContainer & sc)
+    /**Copies the suspended coroutine into child, which must not have been started & must stay where it is.
+     *
+     * Only the live region gets copied, the frame chain & the references to the coroutine are rebased.
+     * Pointers to locals, e.g. references to the yield handle, are left to relocate. The default rebases every word
+     * that looks like one, no_relocate skips that for frames known to hold none.
+     * Returns false if the live region doesn't fit into the stack of the child.
+     */
+    template<typename Relocate = fork_rebase_all>
+    bool fork(coroutine & child, Relocate && relocate = {}) const
     {
-        coroutine cr(sc);
-        cr._stack_ptr = cr._stack_end - (_stack_end - _stack_ptr);
-        std::copy(_stack_ptr, _stack_end, cr._stack_ptr);
-        return cr;
+        if (!embo::detail::coroutine::fork_stack(*this, child, this, &child, embo::detail::coroutine::frame_pointer_slot<Context>::value))
+            return false;
+        relocate(fork_relocation(_stack_ptr, _stack_end, child._stack_ptr));
+        child._started = _started;
+        child._exited  = _exited;
+        return true;
     }
 
     PushType yield_(Return ret)
     {
-        return static_cast<PushType>(embo::detail::coroutine::switch_context<PushType, Return>(static_cast<Return>(ret), this));
+        return embo::detail::coroutine::switch_context<Context, PushType, Return>(static_cast<Return&&>(ret), this);
+    }
+
+    PushType transfer_to_(coroutine & target, PushType pt)
+    {
+        //target takes over the resumer, this one is left suspended in its place.
+        std::swap(_stack_ptr, target._stack_ptr);
+        return embo::detail::coroutine::switch_context<Context, PushType, PushType>(static_cast<PushType&&>(pt), this);
     }
 
     Return reenter(PushType pt)
     {
-        return embo::detail::coroutine::switch_context<Return, PushType>(static_cast<PushType>(pt), this);
+        return embo::detail::coroutine::switch_context<Context, Return, PushType>(static_cast<PushType&&>(pt), this);
     }
 
     template<typename Function>
@@ -336,27 +1151,27 @@ public:
             Return val = static_cast<Return>(func({this_}));
 
             this_->_exited = true;
-            return embo::detail::coroutine::switch_context<PushType, Return>(static_cast<Return>(val), this_);
+            embo::detail::coroutine::switch_context<Context, void>(static_cast<Return&&>(val), this_);
         };
-        return static_cast<Return>(embo::detail::coroutine::make_context<Return>(this, &func, reinterpret_cast<void*>(executor)));
+        return static_cast<Return>(embo::detail::coroutine::make_context<Context, Return>(this, &func, reinterpret_cast<void*>(executor)));
     }
 
     template<typename Function>
     Return spawn(Function && func, PushType pt)
     {
-        auto executor = +[](coroutine * const this_, typename std::remove_reference<Function>::type *func_p, PushType pt)
+        auto executor = +[](coroutine * const this_, typename std::remove_reference<Function>::type *func_p, embo::detail::coroutine::make_transfer_t<PushType> pt)
         {
             this_->_started = true;
             Function func = std::forward<Function>(*func_p);
-            Return val = static_cast<Return>(func({this_}, static_cast<PushType>(pt)));
+            Return val = static_cast<Return>(func({this_}, embo::detail::coroutine::make_transfer<PushType>::receive(pt)));
 
             this_->_exited = true;
-            return embo::detail::coroutine::switch_context(static_cast<Return>(val), this_);
+            embo::detail::coroutine::switch_context<Context, void>(static_cast<Return&&>(val), this_);
         };
-        return static_cast<Return>(embo::detail::coroutine::make_context<Return, PushType>(
+        return static_cast<Return>(embo::detail::coroutine::make_context<Context, Return, PushType>(
                 this, &func,
                 reinterpret_cast<void*>(executor),
-                static_cast<PushType>(pt)));
+                static_cast<PushType&&>(pt)));
     }
 
     Return spawn(return_type(&func)(yield_type)) {return static_cast<Return>(spawn(&func));}
@@ -368,9 +1183,9 @@ public:
             Return val = static_cast<Return>(func(yield_type{this_}));
             this_->_exited = true;
 
-            return embo::detail::coroutine::switch_context(static_cast<Return>(val), this_);
+            embo::detail::coroutine::switch_context<Context, void>(static_cast<Return&&>(val), this_);
         };
-        return embo::detail::coroutine::make_context<Return>(this, func, reinterpret_cast<void*>(executor));
+        return embo::detail::coroutine::make_context<Context, Return>(this, func, reinterpret_cast<void*>(executor));
     }
 
     Return spawn(return_type(&func)(yield_type), Return rt) {return static_cast<Return>(spawn(&func), static_cast<Return>(rt));}
@@ -382,37 +1197,42 @@ public:
             Return val = static_cast<Return>(func({this_}, static_cast<Return>(rt)));
             this_->_exited = true;
 
-            return embo::detail::coroutine::switch_context(static_cast<Return>(val), this_);
+            embo::detail::coroutine::switch_context<Context, void>(static_cast<Return&&>(val), this_);
         };
-        return embo::detail::coroutine::make_context<Return>(this, func, reinterpret_cast<void*>(executor), static_cast<Return>(rt));
+        return embo::detail::coroutine::make_context<Context, Return>(this, func, reinterpret_cast<void*>(executor), static_cast<Return>(rt));
     }
 
-    Return operator()(PushType pt){return reenter(static_cast<PushType>(pt));}
+    Return operator()(PushType pt){return reenter(static_cast<PushType&&>(pt));}
 
     bool started() const {return _started;}
     bool  exited() const {return _exited;}
 
-    std::uint32_t stack_ptr () const { return _stack_ptr; }
+    std::uintptr_t stack_ptr () const { return _stack_ptr; }
     std::size_t   stack_size() const { return _stack_end - _stack_begin; }
     std::size_t   stack_used() const { return _stack_end - _stack_ptr - sizeof(std::uint32_t); }
     std::size_t   stack_left() const { return _stack_begin >= _stack_ptr ? 0ul : (_stack_ptr - _stack_begin); }
+
+    ///Fills the unused part of the stack with the paint pattern, so stack_high_water starts at the current depth.
+    void paint_stack() { embo::detail::coroutine::paint_stack(_stack_begin, _stack_ptr); }
+    ///The peak stack usage in bytes since the stack was painted.
+    std::size_t stack_high_water() const { return embo::detail::coroutine::stack_high_water(_stack_begin, _stack_end); }
 };
 
 
-template<typename PushType>
-class coroutine<void(PushType)> : ::embo::detail::coroutine::impl
+template<typename PushType, typename Context>
+class coroutine<void(PushType), Context> : ::embo::detail::coroutine::impl
 {
     bool _started = false;
     bool _exited  = false;
 
-    template<typename T>
-    friend struct yield_t;
+    template<typename, typename>
+    friend class yield_t;
 
 public:
 
     typedef void return_type;
     typedef void push_type;
-    typedef yield_t<void()> yield_type;
+    typedef yield_t<void(), Context> yield_type;
 
     template<typename StackContainer>
     coroutine(StackContainer & sc) : ::embo::detail::coroutine::impl(
@@ -422,7 +1242,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc.data() + sc.size())
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
     template<typename T, std::size_t Size>
     coroutine(T(&sc)[Size]) : ::embo::detail::coroutine::impl(
@@ -432,7 +1256,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc + Size)
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
     coroutine(const coroutine & cr) = delete;
     coroutine(coroutine && cr) = default;
@@ -441,23 +1269,38 @@ public:
     coroutine& operator=(coroutine && cr) = default;
 
 
-    template<typename StackContainer>
-    coroutine fork(StackContainer & sc)
+    /**Copies the suspended coroutine into child, which must not have been started & must stay where it is.
+     *
+     * Only the live region gets copied, the frame chain & the references to the coroutine are rebased.
+     * Pointers to locals, e.g. references to the yield handle, are left to relocate. The default rebases every word
+     * that looks like one, no_relocate skips that for frames known to hold none.
+     * Returns false if the live region doesn't fit into the stack of the child.
+     */
+    template<typename Relocate = fork_rebase_all>
+    bool fork(coroutine & child, Relocate && relocate = {}) const
     {
-        coroutine cr(sc);
-        cr._stack_ptr = cr._stack_end - (_stack_end - _stack_ptr);
-        std::copy(_stack_ptr, _stack_end, cr._stack_ptr);
-        return cr;
+        if (!embo::detail::coroutine::fork_stack(*this, child, this, &child, embo::detail::coroutine::frame_pointer_slot<Context>::value))
+            return false;
+        relocate(fork_relocation(_stack_ptr, _stack_end, child._stack_ptr));
+        child._started = _started;
+        child._exited  = _exited;
+        return true;
     }
 
     PushType yield_()
     {
-        return static_cast<PushType>(embo::detail::coroutine::switch_context<PushType>(this));
+        return static_cast<PushType>(embo::detail::coroutine::switch_context<Context, PushType>(this));
+    }
+
+    PushType transfer_to_(coroutine & target, PushType pt)
+    {
+        std::swap(_stack_ptr, target._stack_ptr);
+        return embo::detail::coroutine::switch_context<Context, PushType, PushType>(static_cast<PushType&&>(pt), this);
     }
 
     void reenter(PushType pt)
     {
-        embo::detail::coroutine::switch_context<void>( static_cast<PushType>(pt), this);
+        embo::detail::coroutine::switch_context<Context, void, PushType>(static_cast<PushType&&>(pt), this);
     }
 
     template<typename Function>
@@ -470,9 +1313,9 @@ public:
             func({this_});
             this_->_exited = true;
 
-            embo::detail::coroutine::switch_context<void>(this_);
+            embo::detail::coroutine::switch_context<Context, void>(this_);
         };
-        embo::detail::coroutine::make_context<void>(
+        embo::detail::coroutine::make_context<Context, void>(
                 this,
                 reinterpret_cast<void*>(&func),
                 reinterpret_cast<void*>(executor));
@@ -482,20 +1325,20 @@ public:
     template<typename Function>
     void spawn(Function && func, PushType pt)
     {
-        auto executor = +[](coroutine * const this_, typename std::remove_reference<Function>::type *func_p, PushType pt)
+        auto executor = +[](coroutine * const this_, typename std::remove_reference<Function>::type *func_p, embo::detail::coroutine::make_transfer_t<PushType> pt)
         {
             this_->_started = true;
             Function func = static_cast<Function>(*func_p);
-            func({this_}, static_cast<PushType>(pt));
+            func({this_}, embo::detail::coroutine::make_transfer<PushType>::receive(pt));
             this_->_exited = true;
 
-            embo::detail::coroutine::switch_context<void>(this_);
+            embo::detail::coroutine::switch_context<Context, void>(this_);
         };
-        embo::detail::coroutine::make_context<void, PushType>(
+        embo::detail::coroutine::make_context<Context, void, PushType>(
                 this,
                 reinterpret_cast<void*>(&func),
                 reinterpret_cast<void*>(executor),
-                static_cast<PushType>(pt));
+                static_cast<PushType&&>(pt));
     }
 
     void spawn(return_type(&func)(yield_type)) {spawn(&func);}
@@ -507,57 +1350,62 @@ public:
             func({this_});
             this_->_exited = true;
 
-            embo::detail::coroutine::switch_context<void>(this_);
+            embo::detail::coroutine::switch_context<Context, void>(this_);
         };
-        embo::detail::coroutine::make_context<void>(this, reinterpret_cast<void*>(func), reinterpret_cast<void*>(executor));
+        embo::detail::coroutine::make_context<Context, void>(this, reinterpret_cast<void*>(func), reinterpret_cast<void*>(executor));
     }
 
-    void spawn(return_type(&func)(yield_type, PushType), PushType pt) {spawn(&func, static_cast<PushType>(pt));}
+    void spawn(return_type(&func)(yield_type, PushType), PushType pt) {spawn(&func, static_cast<PushType&&>(pt));}
     void spawn(return_type(*func)(yield_type, PushType), PushType pt)
     {
-        auto executor = +[](coroutine * const this_, return_type(*func)(yield_type), PushType pt)
+        auto executor = +[](coroutine * const this_, return_type(*func)(yield_type), embo::detail::coroutine::make_transfer_t<PushType> pt)
         {
             this_->_started = true;
-            func({this_}, static_cast<PushType>(pt));
+            func({this_}, embo::detail::coroutine::make_transfer<PushType>::receive(pt));
             this_->_exited = true;
 
-            embo::detail::coroutine::switch_context<void>(this_);
+            embo::detail::coroutine::switch_context<Context, void>(this_);
         };
-        embo::detail::coroutine::make_context<void, PushType>(
+        embo::detail::coroutine::make_context<Context, void, PushType>(
                 this,
                 reinterpret_cast<void*>(func),
                 reinterpret_cast<void*>(executor),
-                static_cast<PushType>(pt));
+                static_cast<PushType&&>(pt));
     }
 
-    void operator()(PushType pt){reenter(static_cast<PushType>(pt));}
+    void operator()(PushType pt){reenter(static_cast<PushType&&>(pt));}
 
     bool started() const {return _started;}
     bool  exited() const {return _exited;}
 
-    std::uint32_t stack_ptr () const { return _stack_ptr; }
+    std::uintptr_t stack_ptr () const { return _stack_ptr; }
     std::size_t   stack_size() const { return _stack_end - _stack_begin; }
     std::size_t   stack_used() const { return _stack_end - _stack_ptr - sizeof(std::uint32_t); }
     std::size_t   stack_left() const { return _stack_begin >= _stack_ptr ? 0ul : (_stack_ptr - _stack_begin); }
+
+    ///Fills the unused part of the stack with the paint pattern, so stack_high_water starts at the current depth.
+    void paint_stack() { embo::detail::coroutine::paint_stack(_stack_begin, _stack_ptr); }
+    ///The peak stack usage in bytes since the stack was painted.
+    std::size_t stack_high_water() const { return embo::detail::coroutine::stack_high_water(_stack_begin, _stack_end); }
 };
 
 
-template<typename Return>
-class coroutine<Return()> : ::embo::detail::coroutine::impl
+template<typename Return, typename Context>
+class coroutine<Return(), Context> : ::embo::detail::coroutine::impl
 {
-    static_assert(embo::detail::coroutine::is_valid_type_t<Return>::value,   "The return type must either be a 64-bit integral type or a 32-bit compound type");
+    static_assert(std::is_move_constructible<Return>::value, "The return type must be move constructible");
 
     bool _started = false;
     bool _exited  = false;
 
-    template<typename T>
-    friend struct yield_t;
+    template<typename, typename>
+    friend class yield_t;
 
 public:
 
     typedef Return return_type;
     typedef void push_type;
-    typedef yield_t<Return()> yield_type;
+    typedef yield_t<Return(), Context> yield_type;
 
     template<typename StackContainer>
     coroutine(StackContainer & sc) : ::embo::detail::coroutine::impl(
@@ -567,7 +1415,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc.data() + sc.size())
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
     template<typename T, std::size_t Size>
     coroutine(T(&sc)[Size]) : ::embo::detail::coroutine::impl(
@@ -577,7 +1429,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc + Size)
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
     coroutine(const coroutine & cr) = delete;
     coroutine(coroutine && cr) = default;
@@ -586,23 +1442,38 @@ public:
     coroutine& operator=(coroutine && cr) = default;
 
 
-    template<typename StackContainer>
-    coroutine fork(StackContainer & sc)
+    /**Copies the suspended coroutine into child, which must not have been started & must stay where it is.
+     *
+     * Only the live region gets copied, the frame chain & the references to the coroutine are rebased.
+     * Pointers to locals, e.g. references to the yield handle, are left to relocate. The default rebases every word
+     * that looks like one, no_relocate skips that for frames known to hold none.
+     * Returns false if the live region doesn't fit into the stack of the child.
+     */
+    template<typename Relocate = fork_rebase_all>
+    bool fork(coroutine & child, Relocate && relocate = {}) const
     {
-        coroutine cr(sc);
-        cr._stack_ptr = cr._stack_end - (_stack_end - _stack_ptr);
-        std::copy(_stack_ptr, _stack_end, cr._stack_ptr);
-        return cr;
+        if (!embo::detail::coroutine::fork_stack(*this, child, this, &child, embo::detail::coroutine::frame_pointer_slot<Context>::value))
+            return false;
+        relocate(fork_relocation(_stack_ptr, _stack_end, child._stack_ptr));
+        child._started = _started;
+        child._exited  = _exited;
+        return true;
     }
 
     void yield_(Return ret)
     {
-        embo::detail::coroutine::switch_context<Return>(static_cast<Return>(ret), this);
+        embo::detail::coroutine::switch_context<Context, void>(static_cast<Return&&>(ret), this);
+    }
+
+    void transfer_to_(coroutine & target)
+    {
+        std::swap(_stack_ptr, target._stack_ptr);
+        embo::detail::coroutine::switch_context<Context, void>(this);
     }
 
     Return reenter()
     {
-        return embo::detail::coroutine::switch_context<Return>(this);
+        return embo::detail::coroutine::switch_context<Context, Return>(this);
     }
 
     template<typename Function>
@@ -615,9 +1486,9 @@ public:
             Return val = static_cast<Return>(func({this_}));
 
             this_->_exited = true;
-            return embo::detail::coroutine::switch_context<Return>(static_cast<Return>(val), this_);
+            embo::detail::coroutine::switch_context<Context, void>(static_cast<Return&&>(val), this_);
         };
-        return embo::detail::coroutine::make_context<Return>(this, &func, reinterpret_cast<void*>(executor));
+        return embo::detail::coroutine::make_context<Context, Return>(this, &func, reinterpret_cast<void*>(executor));
     }
 
     Return spawn(return_type(&func)(yield_type)) {return spawn(&func);}
@@ -629,9 +1500,9 @@ public:
             Return val = static_cast<Return>(func(yield_type{this_}));
             this_->_exited = true;
 
-            return embo::detail::coroutine::switch_context(static_cast<Return>(val), this_);
+            embo::detail::coroutine::switch_context<Context, void>(static_cast<Return&&>(val), this_);
         };
-        return embo::detail::coroutine::make_context<Return>(this, func, reinterpret_cast<void*>(executor));
+        return embo::detail::coroutine::make_context<Context, Return>(this, func, reinterpret_cast<void*>(executor));
     }
 
     Return operator()(){return reenter();}
@@ -639,27 +1510,32 @@ public:
     bool started() const {return _started;}
     bool  exited() const {return _exited;}
 
-    std::uint32_t stack_ptr () const { return _stack_ptr; }
+    std::uintptr_t stack_ptr () const { return _stack_ptr; }
     std::size_t   stack_size() const { return _stack_end - _stack_begin; }
     std::size_t   stack_used() const { return _stack_end - _stack_ptr - sizeof(std::uint32_t); }
     std::size_t   stack_left() const { return _stack_begin >= _stack_ptr ? 0ul : (_stack_ptr - _stack_begin); }
+
+    ///Fills the unused part of the stack with the paint pattern, so stack_high_water starts at the current depth.
+    void paint_stack() { embo::detail::coroutine::paint_stack(_stack_begin, _stack_ptr); }
+    ///The peak stack usage in bytes since the stack was painted.
+    std::size_t stack_high_water() const { return embo::detail::coroutine::stack_high_water(_stack_begin, _stack_end); }
 };
 
 
-template<>
-class coroutine<void()> : ::embo::detail::coroutine::impl
+template<typename Context>
+class coroutine<void(), Context> : ::embo::detail::coroutine::impl
 {
     bool _started = false;
     bool _exited  = false;
 
-    template<typename T>
-    friend struct yield_t;
+    template<typename, typename>
+    friend class yield_t;
 
 public:
 
     typedef void return_type;
     typedef void push_type;
-    typedef yield_t<void()> yield_type;
+    typedef yield_t<void(), Context> yield_type;
 
     template<typename StackContainer>
     coroutine(StackContainer & sc) : ::embo::detail::coroutine::impl(
@@ -669,7 +1545,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc.data() + sc.size())
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
     template<typename T, std::size_t Size>
     coroutine(T(&sc)[Size]) : ::embo::detail::coroutine::impl(
@@ -679,7 +1559,11 @@ public:
                 reinterpret_cast<std::uintptr_t>(sc + Size)
             }
             )
-    {}
+    {
+#if defined(EMBO_COROUTINE_PAINT_STACK)
+        paint_stack();
+#endif
+    }
 
 
     coroutine(const coroutine & cr) = delete;
@@ -689,23 +1573,38 @@ public:
     coroutine& operator=(coroutine && cr) = default;
 
 
-    template<typename StackContainer>
-    coroutine fork(StackContainer & sc)
+    /**Copies the suspended coroutine into child, which must not have been started & must stay where it is.
+     *
+     * Only the live region gets copied, the frame chain & the references to the coroutine are rebased.
+     * Pointers to locals, e.g. references to the yield handle, are left to relocate. The default rebases every word
+     * that looks like one, no_relocate skips that for frames known to hold none.
+     * Returns false if the live region doesn't fit into the stack of the child.
+     */
+    template<typename Relocate = fork_rebase_all>
+    bool fork(coroutine & child, Relocate && relocate = {}) const
     {
-        coroutine cr(sc);
-        cr._stack_ptr = cr._stack_end - (_stack_end - _stack_ptr);
-        std::copy(_stack_ptr, _stack_end, cr._stack_ptr);
-        return cr;
+        if (!embo::detail::coroutine::fork_stack(*this, child, this, &child, embo::detail::coroutine::frame_pointer_slot<Context>::value))
+            return false;
+        relocate(fork_relocation(_stack_ptr, _stack_end, child._stack_ptr));
+        child._started = _started;
+        child._exited  = _exited;
+        return true;
     }
 
     void yield_()
     {
-        embo::detail::coroutine::switch_context<void>(this);
+        embo::detail::coroutine::switch_context<Context, void>(this);
+    }
+
+    void transfer_to_(coroutine & target)
+    {
+        std::swap(_stack_ptr, target._stack_ptr);
+        embo::detail::coroutine::switch_context<Context, void>(this);
     }
 
     void reenter()
     {
-        embo::detail::coroutine::switch_context<void>(this);
+        embo::detail::coroutine::switch_context<Context, void>(this);
     }
 
     template<typename Function>
@@ -718,9 +1617,9 @@ public:
             func({this_});
             this_->_exited = true;
 
-            embo::detail::coroutine::switch_context<void>(this_);
+            embo::detail::coroutine::switch_context<Context, void>(this_);
         };
-        embo::detail::coroutine::make_context<void>(this, reinterpret_cast<void*>(&func), reinterpret_cast<void*>(executor));
+        embo::detail::coroutine::make_context<Context, void>(this, reinterpret_cast<void*>(&func), reinterpret_cast<void*>(executor));
     }
 
     void spawn(return_type(&func)(yield_type)) {return spawn(&func);}
@@ -732,9 +1631,9 @@ public:
             func({this_});
             this_->_exited = true;
 
-            embo::detail::coroutine::switch_context<void>(this_);
+            embo::detail::coroutine::switch_context<Context, void>(this_);
         };
-        embo::detail::coroutine::make_context<void>(this, reinterpret_cast<void*>(func), reinterpret_cast<void*>(executor));
+        embo::detail::coroutine::make_context<Context, void>(this, reinterpret_cast<void*>(func), reinterpret_cast<void*>(executor));
     }
 
     void operator()(){reenter();}
@@ -742,137 +1641,158 @@ public:
     bool started() const {return _started;}
     bool  exited() const {return _exited;}
 
-    std::uint32_t stack_ptr () const { return _stack_ptr; }
+    std::uintptr_t stack_ptr () const { return _stack_ptr; }
     std::size_t   stack_size() const { return _stack_end - _stack_begin; }
     std::size_t   stack_used() const { return _stack_end - _stack_ptr - sizeof(std::uint32_t); }
     std::size_t   stack_left() const { return _stack_begin >= _stack_ptr ? 0ul : (_stack_ptr - _stack_begin); }
+
+    ///Fills the unused part of the stack with the paint pattern, so stack_high_water starts at the current depth.
+    void paint_stack() { embo::detail::coroutine::paint_stack(_stack_begin, _stack_ptr); }
+    ///The peak stack usage in bytes since the stack was painted.
+    std::size_t stack_high_water() const { return embo::detail::coroutine::stack_high_water(_stack_begin, _stack_end); }
 };
 
 
-template<typename Return, typename PushType>
-PushType yield_t<Return(PushType)>::operator()(Return rt)
+template<typename Return, typename PushType, typename Context>
+PushType yield_t<Return(PushType), Context>::operator()(Return rt)
 {
-    return static_cast<Return>(_cr->yield_(static_cast<Return>(rt)));
+    return _cr->yield_(static_cast<Return&&>(rt));
 }
 
-template<typename Return>
-void yield_t<Return()>::operator()(Return rt) {_cr->yield_(static_cast<Return>(rt));}
+template<typename Return, typename Context>
+void yield_t<Return(), Context>::operator()(Return rt) {_cr->yield_(static_cast<Return&&>(rt));}
 
 
-template<typename PushType>
-PushType yield_t<void(PushType)>::operator()() {return static_cast<PushType>(_cr->yield_());}
+template<typename PushType, typename Context>
+PushType yield_t<void(PushType), Context>::operator()() {return _cr->yield_();}
 
-void yield_t<void()>::operator()() {_cr->yield_();}
+template<typename Context>
+void yield_t<void(), Context>::operator()() {_cr->yield_();}
 
 
+template<typename Return, typename PushType, typename Context>
+PushType yield_t<Return(PushType), Context>::transfer_to(coroutine<Return(PushType), Context> & target, PushType pt)
+{
+    return _cr->transfer_to_(target, static_cast<PushType&&>(pt));
+}
 
+template<typename Return, typename Context>
+void yield_t<Return(), Context>::transfer_to(coroutine<Return(), Context> & target) {_cr->transfer_to_(target);}
 
-template<typename Return, typename PushType>
-std::uint32_t yield_t<Return(PushType)>::stack_ptr () const
+template<typename PushType, typename Context>
+PushType yield_t<void(PushType), Context>::transfer_to(coroutine<void(PushType), Context> & target, PushType pt)
+{
+    return _cr->transfer_to_(target, static_cast<PushType&&>(pt));
+}
+
+template<typename Context>
+void yield_t<void(), Context>::transfer_to(coroutine<void(), Context> & target) {_cr->transfer_to_(target);}
+
+
+
+
+template<typename Return, typename PushType, typename Context>
+std::uintptr_t yield_t<Return(PushType), Context>::stack_ptr () const
 {
     return _cr->stack_ptr();
 }
 
-template<typename Return, typename PushType>
-std::size_t   yield_t<Return(PushType)>::stack_size() const
+template<typename Return, typename PushType, typename Context>
+std::size_t   yield_t<Return(PushType), Context>::stack_size() const
 {
     return _cr->stack_size();
 }
 
-template<typename Return, typename PushType>
-std::size_t   yield_t<Return(PushType)>::stack_used() const
+template<typename Return, typename PushType, typename Context>
+std::size_t   yield_t<Return(PushType), Context>::stack_used() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr)); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_end - stack_ptr + sizeof(std::uint32_t);
 }
 
-template<typename Return, typename PushType>
-std::size_t   yield_t<Return(PushType)>::stack_left() const
+template<typename Return, typename PushType, typename Context>
+std::size_t   yield_t<Return(PushType), Context>::stack_left() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr) : : "sp"); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_begin >= stack_ptr ? 0ul : (stack_ptr - _cr->_stack_begin);
 }
 
-template<typename Return>
-std::uint32_t yield_t<Return()>::stack_ptr () const
+template<typename Return, typename Context>
+std::uintptr_t yield_t<Return(), Context>::stack_ptr () const
 {
     return _cr->stack_ptr();
 }
 
-template<typename Return>
-std::size_t   yield_t<Return()>::stack_size() const
+template<typename Return, typename Context>
+std::size_t   yield_t<Return(), Context>::stack_size() const
 {
     return _cr->stack_size();
 }
 
-template<typename Return>
-std::size_t   yield_t<Return()>::stack_used() const
+template<typename Return, typename Context>
+std::size_t   yield_t<Return(), Context>::stack_used() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr)); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_end - stack_ptr + sizeof(std::uint32_t);
 }
 
-template<typename Return>
-std::size_t   yield_t<Return()>::stack_left() const
+template<typename Return, typename Context>
+std::size_t   yield_t<Return(), Context>::stack_left() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr) : : "sp"); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_begin >= stack_ptr ? 0ul : (stack_ptr - _cr->_stack_begin);
 }
 
-template<typename PushType>
-std::uint32_t yield_t<void(PushType)>::stack_ptr () const
+template<typename PushType, typename Context>
+std::uintptr_t yield_t<void(PushType), Context>::stack_ptr () const
 {
     return _cr->stack_ptr();
 }
 
-template<typename PushType>
-std::size_t   yield_t<void(PushType)>::stack_size() const
+template<typename PushType, typename Context>
+std::size_t   yield_t<void(PushType), Context>::stack_size() const
 {
     return _cr->stack_size();
 }
 
-template<typename PushType>
-std::size_t   yield_t<void(PushType)>::stack_used() const
+template<typename PushType, typename Context>
+std::size_t   yield_t<void(PushType), Context>::stack_used() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr)); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_end - stack_ptr + sizeof(std::uint32_t);
 }
 
-template<typename PushType>
-std::size_t   yield_t<void(PushType)>::stack_left() const
+template<typename PushType, typename Context>
+std::size_t   yield_t<void(PushType), Context>::stack_left() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr) : : "sp"); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_begin >= stack_ptr ? 0ul : (stack_ptr - _cr->_stack_begin);
 }
 
 
-std::uint32_t yield_t<void()>::stack_ptr () const
+template<typename Context>
+std::uintptr_t yield_t<void(), Context>::stack_ptr () const
 {
     return _cr->stack_ptr();
 }
 
-std::size_t   yield_t<void()>::stack_size() const
+template<typename Context>
+std::size_t   yield_t<void(), Context>::stack_size() const
 {
     return _cr->stack_size();
 }
 
-std::size_t   yield_t<void()>::stack_used() const
+template<typename Context>
+std::size_t   yield_t<void(), Context>::stack_used() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr)); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_end - stack_ptr + sizeof(std::uint32_t);
 }
 
-std::size_t   yield_t<void()>::stack_left() const
+template<typename Context>
+std::size_t   yield_t<void(), Context>::stack_left() const
 {
-    std::uint32_t stack_ptr;
-    __asm__("mov %0, sp" : "=r"(stack_ptr) : : "sp"); //get the stack_ptr
+    auto stack_ptr = embo::detail::coroutine::current_stack_ptr();
     return _cr->_stack_begin >= stack_ptr ? 0ul : (stack_ptr - _cr->_stack_begin);
 }
 
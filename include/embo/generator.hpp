@@ -0,0 +1,124 @@
+/**
+ * @file   embo/generator.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_GENERATOR_HPP_
+#define EMBO_GENERATOR_HPP_
+
+#include <embo/coroutine.hpp>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace embo
+{
+
+/**Range over the values of a coroutine<T()>, for range-for & the algorithms of the standard library.
+ *
+ * The coroutine gets spawned by the constructor, so the first value is computed right away.
+ * The range holds every yielded value followed by the returned one, i.e. exactly the values
+ * spawn & reenter return. Advancing past the returned value ends the range, which is detected
+ * by the exited flag of the coroutine, so no sentinel value is needed.
+ *
+ * @code{.cpp}
+ * embo::generator<int> gen{stack, [](embo::yield_t<int()> yield_) {yield_(1); yield_(2); return 3;}};
+ * for (auto i : gen) //1, 2, 3
+ *     use(i);
+ * @endcode
+ */
+template<typename T, typename Context = default_context>
+class generator
+{
+    coroutine<T(), Context> _cr;
+    alignas(T) unsigned char _value[sizeof(T)];
+    bool _done = false;
+
+    T & value() {return *reinterpret_cast<T*>(_value);}
+
+    void advance()
+    {
+        if (_cr.exited())
+            _done = true;
+        else
+            value() = _cr.reenter();
+    }
+
+public:
+    typedef T value_type;
+
+    class iterator
+    {
+        generator * _gen;
+
+        bool done() const {return !_gen || _gen->_done;}
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T * pointer;
+        typedef T & reference;
+
+        explicit iterator(generator * gen = nullptr) : _gen(gen) {}
+
+        reference operator*()  const {return _gen->value();}
+        pointer   operator->() const {return &_gen->value();}
+
+        iterator & operator++()
+        {
+            _gen->advance();
+            return *this;
+        }
+        ///Holds the previous value, since the generator doesn't keep it.
+        struct proxy
+        {
+            T value;
+            T & operator*() {return value;}
+        };
+
+        proxy operator++(int)
+        {
+            proxy p{static_cast<T&&>(_gen->value())};
+            _gen->advance();
+            return p;
+        }
+
+        bool operator==(const iterator & rhs) const {return done() == rhs.done();}
+        bool operator!=(const iterator & rhs) const {return done() != rhs.done();}
+    };
+
+    ///Spawns the function `T(yield_t<T(), Context>)` on the stack.
+    template<typename StackContainer, typename Function>
+    generator(StackContainer & sc, Function && func) : _cr(sc)
+    {
+        new (_value) T(_cr.spawn(std::forward<Function>(func)));
+    }
+
+    template<typename U, std::size_t Size, typename Function>
+    generator(U(&sc)[Size], Function && func) : _cr(sc)
+    {
+        new (_value) T(_cr.spawn(std::forward<Function>(func)));
+    }
+
+    generator(const generator & ) = delete;
+    generator& operator=(const generator & ) = delete;
+
+    ~generator() {value().~T();}
+
+    ///The current value, a generator is a single pass range, so every iterator refers to the same position.
+    iterator begin() {return iterator(this);}
+    iterator end()   {return iterator();}
+
+    ///If the range is exhausted, i.e. the returned value has been passed.
+    bool done() const {return _done;}
+    bool exited() const {return _cr.exited();}
+
+    std::size_t stack_size() const {return _cr.stack_size();}
+    std::size_t stack_used() const {return _cr.stack_used();}
+};
+
+}
+
+#endif /* EMBO_GENERATOR_HPP_ */
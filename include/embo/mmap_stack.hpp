@@ -0,0 +1,159 @@
+/**
+ * @file   embo/mmap_stack.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_MMAP_STACK_HPP_
+#define EMBO_MMAP_STACK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace embo
+{
+
+/**Growable stack for hosts, backed by an anonymous mapping.
+ *
+ * The whole range is only reserved, the kernel commits the pages when they get touched,
+ * so the resident memory follows the real depth of the coroutine. The lowest page is a PROT_NONE guard,
+ * hence an overflow faults instead of running into the neighbouring memory.
+ * Note that EMBO_COROUTINE_PAINT_STACK touches the whole stack & thus commits it.
+ *
+ * It fulfills the StackContainer of the coroutine. If the mapping fails the stack is empty, i.e. data() returns nullptr.
+ */
+class mmap_stack
+{
+    void * _mapping = nullptr;
+    std::size_t _length = 0u;
+
+    static std::size_t page_size() {return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));}
+
+public:
+    mmap_stack() = default;
+
+    ///Reserves at least `size` bytes of stack, rounded up to full pages, plus the guard page.
+    explicit mmap_stack(std::size_t size)
+    {
+        const auto page = page_size();
+        const auto length = ((size + page - 1u) / page + 1u) * page;
+        auto mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapping == MAP_FAILED)
+            return;
+
+        if (::mprotect(mapping, page, PROT_NONE) != 0)
+        {
+            ::munmap(mapping, length);
+            return;
+        }
+        _mapping = mapping;
+        _length  = length;
+    }
+
+    mmap_stack(const mmap_stack & ) = delete;
+    mmap_stack(mmap_stack && lhs) : _mapping(lhs._mapping), _length(lhs._length)
+    {
+        lhs._mapping = nullptr;
+        lhs._length  = 0u;
+    }
+
+    mmap_stack& operator=(const mmap_stack & ) = delete;
+    mmap_stack& operator=(mmap_stack && lhs)
+    {
+        if (this != &lhs)
+        {
+            release();
+            _mapping = lhs._mapping;
+            _length  = lhs._length;
+            lhs._mapping = nullptr;
+            lhs._length  = 0u;
+        }
+        return *this;
+    }
+
+    ~mmap_stack() {release();}
+
+    ///Unmaps the stack, it must not be in use by a coroutine anymore.
+    void release()
+    {
+        if (_mapping)
+            ::munmap(_mapping, _length);
+        _mapping = nullptr;
+        _length  = 0u;
+    }
+
+    ///The usable stack, i.e. above the guard page.
+    std::uint32_t * data() const
+    {
+        return _mapping ? reinterpret_cast<std::uint32_t*>(static_cast<char*>(_mapping) + page_size()) : nullptr;
+    }
+
+    std::size_t size() const {return _mapping ? (_length - page_size()) / sizeof(std::uint32_t) : 0u;}
+
+    explicit operator bool() const {return _mapping != nullptr;}
+};
+
+/**Recycle policy for the stack_pool, that gives the memory of released stacks back to the OS.
+ *
+ * The pool keeps a warm depth, which jumps to the resident depth of a released stack if it is deeper
+ * & otherwise decays by 1/Decay per release. Everything below the warm depth gets advised away,
+ * so hot stacks stay committed, while the pages of a spike are released once the traffic calms down.
+ *
+ * The resident depth is determined with mincore. MADV_DONTNEED drops the pages right away,
+ * MADV_FREE is cheaper, but the pages only leave the RSS under memory pressure and still count as resident until then.
+ */
+template<int Advice = MADV_DONTNEED, std::size_t Decay = 4u>
+class madvise_recycle
+{
+    std::atomic<std::size_t> _warm{0u};
+
+    static std::size_t page_size() {return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));}
+
+    //the distance from the end to the lowest resident page.
+    static std::size_t resident_depth(std::uintptr_t begin, std::uintptr_t end, std::size_t page)
+    {
+        unsigned char vec[64];
+        for (auto itr = begin; itr < end; )
+        {
+            const auto pages = std::min<std::size_t>(sizeof(vec), (end - itr) / page);
+            if (::mincore(reinterpret_cast<void*>(itr), pages * page, vec) != 0)
+                return end - begin;
+            for (std::size_t i = 0u; i < pages; i++)
+                if (vec[i] & 1u)
+                    return end - (itr + i * page);
+            itr += pages * page;
+        }
+        return 0u;
+    }
+
+public:
+    void operator()(void * data, std::size_t size)
+    {
+        const auto page  = page_size();
+        const auto begin = (reinterpret_cast<std::uintptr_t>(data) + page - 1u) & ~(page - 1u);
+        const auto end   = (reinterpret_cast<std::uintptr_t>(data) + size) & ~(page - 1u);
+        if (end <= begin)
+            return;
+
+        const auto resident = resident_depth(begin, end, page);
+        auto warm = _warm.load(std::memory_order_relaxed);
+        warm = resident > warm ? resident : warm - warm / Decay;
+        _warm.store(warm, std::memory_order_relaxed);
+
+        const auto keep = (warm + page - 1u) & ~(page - 1u);
+        if ((resident > keep) && ((end - begin) > keep))
+            ::madvise(reinterpret_cast<void*>(begin), (end - begin) - keep, Advice);
+    }
+
+    ///The current warm depth in bytes.
+    std::size_t warm() const {return _warm.load(std::memory_order_relaxed);}
+};
+
+}
+
+#endif /* EMBO_MMAP_STACK_HPP_ */
@@ -0,0 +1,277 @@
+/**
+ * @file   embo/parser.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_PARSER_HPP_
+#define EMBO_PARSER_HPP_
+
+#include <embo/coroutine.hpp>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace embo
+{
+
+///A view of bytes, either into a pushed chunk or into the carry buffer of the reader.
+struct byte_view
+{
+    const std::uint8_t * data;
+    std::size_t size;
+
+    const std::uint8_t & operator[](std::size_t idx) const {return data[idx];}
+    const std::uint8_t * begin() const {return data;}
+    const std::uint8_t * end()   const {return data + size;}
+    bool empty() const {return size == 0u;}
+};
+
+template<std::size_t Capacity, typename Context = default_context>
+class stream_parser;
+
+/**The input of a parser running in a stream_parser.
+ *
+ * The reads hand out views straight into the pushed chunk, if the requested bytes are contiguous.
+ * Only a token that straddles the boundary between two chunks gets copied into the carry buffer of Capacity bytes.
+ * When the chunk runs out, the parser is suspended until the next one is pushed.
+ *
+ * A view is valid until the next read, since the following one might suspend or reuse the carry buffer.
+ * Requests beyond the Capacity can't be satisfied, so read_exact & peek return an empty view for them.
+ */
+template<std::size_t Capacity, typename Context = default_context>
+class byte_reader
+{
+    static_assert(Capacity > 0u, "The carry buffer needs at least one byte");
+
+    typedef yield_t<void(byte_view), Context> yield_type;
+
+    yield_type * _yield = nullptr;
+    const std::uint8_t * _chunk = nullptr;
+    std::size_t _left = 0u;
+
+    std::uint8_t _carry[Capacity];
+    std::size_t _carry_begin = 0u;
+    std::size_t _carry_end   = 0u;
+
+    template<std::size_t, typename>
+    friend class stream_parser;
+
+    void next_chunk()
+    {
+        const auto chunk = (*_yield)();
+        _chunk = chunk.data;
+        _left  = chunk.size;
+    }
+
+    byte_view take_chunk(std::size_t n)
+    {
+        byte_view view{_chunk, n};
+        _chunk += n;
+        _left  -= n;
+        return view;
+    }
+
+    byte_view take_carry(std::size_t n)
+    {
+        byte_view view{_carry + _carry_begin, n};
+        _carry_begin += n;
+        if (_carry_begin == _carry_end)
+            _carry_begin = _carry_end = 0u;
+        return view;
+    }
+
+    std::size_t carried() const {return _carry_end - _carry_begin;}
+
+    void compact()
+    {
+        if (_carry_begin == 0u)
+            return;
+        std::memmove(_carry, _carry + _carry_begin, carried());
+        _carry_end  -= _carry_begin;
+        _carry_begin = 0u;
+    }
+
+    //moves bytes from the chunks into the carry buffer, until it holds n.
+    void fill(std::size_t n)
+    {
+        if (carried() >= n)
+            return;
+        compact();
+        while (_carry_end < n)
+        {
+            if (_left == 0u)
+            {
+                next_chunk();
+                continue;
+            }
+            const auto cnt = std::min(_left, n - _carry_end);
+            std::memcpy(_carry + _carry_end, _chunk, cnt);
+            _carry_end += cnt;
+            _chunk += cnt;
+            _left  -= cnt;
+        }
+    }
+
+public:
+    byte_reader() = default;
+    byte_reader(const byte_reader & ) = delete;
+    byte_reader& operator=(const byte_reader & ) = delete;
+
+    ///Reads exactly n bytes.
+    byte_view read_exact(std::size_t n)
+    {
+        if (carried() == 0u && (_left >= n))
+            return take_chunk(n);
+        if (n > Capacity)
+            return byte_view{nullptr, 0u};
+        fill(n);
+        return take_carry(n);
+    }
+
+    ///Returns the next n bytes without consuming them.
+    byte_view peek(std::size_t n)
+    {
+        if (carried() == 0u && (_left >= n))
+            return byte_view{_chunk, n};
+        if (n > Capacity)
+            return byte_view{nullptr, 0u};
+        fill(n);
+        return byte_view{_carry + _carry_begin, n};
+    }
+
+    std::uint8_t read_byte() {return read_exact(1u)[0];}
+
+    /**Reads up to & including the delimiter.
+     *
+     * If the token doesn't fit into the carry buffer, the first Capacity bytes are returned without the delimiter,
+     * so the parser can tell by the last byte.
+     */
+    byte_view read_until(std::uint8_t delim)
+    {
+        if (carried() == 0u)
+        {
+            auto p = _left == 0u ? nullptr : static_cast<const std::uint8_t*>(std::memchr(_chunk, delim, _left));
+            if (p)
+                return take_chunk(p - _chunk + 1u);
+        }
+        else
+        {
+            auto p = static_cast<const std::uint8_t*>(std::memchr(_carry + _carry_begin, delim, carried()));
+            if (p)
+                return take_carry(p - (_carry + _carry_begin) + 1u);
+        }
+
+        compact();
+        while (true)
+        {
+            auto p = _left == 0u ? nullptr : static_cast<const std::uint8_t*>(std::memchr(_chunk, delim, _left));
+            const std::size_t token = p ? (p - _chunk + 1u) : _left;
+            const auto cnt = std::min(token, Capacity - _carry_end);
+
+            if (cnt != 0u) //an exhausted _chunk may be null, e.g. before the first push
+            {
+                std::memcpy(_carry + _carry_end, _chunk, cnt);
+                _carry_end += cnt;
+                _chunk += cnt;
+                _left  -= cnt;
+            }
+
+            if ((p && (cnt == token)) || (_carry_end == Capacity))
+                return take_carry(_carry_end);
+            next_chunk();
+        }
+    }
+
+    ///Reads whatever is available up to max bytes, only suspends if nothing is. Never copies.
+    byte_view read_some(std::size_t max)
+    {
+        if (carried() != 0u)
+            return take_carry(std::min(max, carried()));
+        while (_left == 0u)
+            next_chunk();
+        return take_chunk(std::min(max, _left));
+    }
+
+    ///The bytes that can be read without suspending.
+    std::size_t available() const {return carried() + _left;}
+};
+
+/**A push coroutine running a parser, which gets the data through a byte_reader.
+ *
+ * The parser has the signature `void(byte_reader<Capacity, Context> &)` & is written as straight-line code,
+ * every read suspends it until enough data has been pushed. The chunk passed to push must stay valid
+ * until push returns, after that the parser only refers to the copied bytes.
+ * Like the coroutine it can be neither copied nor moved once spawned.
+ *
+ * @code{.cpp}
+ * embo::stream_parser<64> parser{stack};
+ * parser.spawn([](embo::byte_reader<64> & in)
+ *     {
+ *         while (true)
+ *         {
+ *             const auto length = in.read_byte();
+ *             handle_frame(in.read_exact(length));
+ *         }
+ *     });
+ * parser.push(rx_buffer, received);
+ * @endcode
+ */
+template<std::size_t Capacity, typename Context>
+class stream_parser
+{
+    coroutine<void(byte_view), Context> _cr;
+    byte_reader<Capacity, Context> _reader;
+
+    template<typename Function>
+    struct executor
+    {
+        Function func;
+        byte_reader<Capacity, Context> * reader;
+
+        void operator()(yield_t<void(byte_view), Context> yield_, byte_view chunk)
+        {
+            reader->_yield = &yield_;
+            reader->_chunk = chunk.data;
+            reader->_left  = chunk.size;
+            func(*reader);
+        }
+    };
+
+public:
+    template<typename StackContainer>
+    stream_parser(StackContainer & sc) : _cr(sc) {}
+
+    template<typename U, std::size_t Size>
+    stream_parser(U(&sc)[Size]) : _cr(sc) {}
+
+    stream_parser(const stream_parser & ) = delete;
+    stream_parser& operator=(const stream_parser & ) = delete;
+
+    ///Starts the parser, it runs until it needs the first data.
+    template<typename Function>
+    void spawn(Function && func)
+    {
+        typedef executor<typename std::decay<Function>::type> executor_type;
+        _cr.spawn(executor_type{std::forward<Function>(func), &_reader}, byte_view{nullptr, 0u});
+    }
+
+    ///Pushes a chunk, the parser runs until it has consumed it. Returns false if the parser has exited.
+    bool push(const void * data, std::size_t size)
+    {
+        if (_cr.exited())
+            return false;
+        _cr.reenter(byte_view{static_cast<const std::uint8_t*>(data), size});
+        return true;
+    }
+
+    bool exited() const {return _cr.exited();}
+
+    std::size_t stack_size() const {return _cr.stack_size();}
+    std::size_t stack_used() const {return _cr.stack_used();}
+};
+
+}
+
+#endif /* EMBO_PARSER_HPP_ */
@@ -0,0 +1,350 @@
+/**
+ * @file   embo/scheduler.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_SCHEDULER_HPP_
+#define EMBO_SCHEDULER_HPP_
+
+#include <embo/coroutine.hpp>
+
+namespace embo
+{
+
+template<typename Context = default_context>
+class round_robin;
+
+template<typename Context = default_context>
+class priority_scheduler;
+
+template<typename Context>
+class task_queue;
+
+/**A coroutine that can be scheduled.
+ *
+ * The hook of the ready queue is embedded, so the scheduler never allocates.
+ * A task is linked by address, hence it can be neither copied nor moved.
+ */
+template<typename Context = default_context>
+class task : public coroutine<void(), Context>
+{
+    task * _next  = nullptr;
+    bool _blocked = false;
+    std::uint8_t _priority = 0u;
+
+    template<typename>
+    friend class round_robin;
+    template<typename>
+    friend class priority_scheduler;
+    template<typename>
+    friend class task_queue;
+public:
+    using coroutine<void(), Context>::coroutine;
+
+    task(const task & ) = delete;
+    task& operator=(const task & ) = delete;
+
+    bool blocked() const {return _blocked;}
+    std::uint8_t priority() const {return _priority;}
+};
+
+///Intrusive FIFO of tasks, linked through their embedded hook.
+template<typename Context>
+class task_queue
+{
+    task<Context> * _head = nullptr;
+    task<Context> * _tail = nullptr;
+public:
+    void push(task<Context> & t)
+    {
+        t._next = nullptr;
+        if (_tail)
+            _tail->_next = &t;
+        else
+            _head = &t;
+        _tail = &t;
+    }
+
+    void push_front(task<Context> & t)
+    {
+        t._next = _head;
+        _head = &t;
+        if (!_tail)
+            _tail = &t;
+    }
+
+    task<Context> * pop()
+    {
+        auto t = _head;
+        if (t)
+        {
+            _head = t->_next;
+            if (!_head)
+                _tail = nullptr;
+        }
+        return t;
+    }
+
+    ///Unlinks the task, O(n) since the queue is singly linked. Returns false if it wasn't queued.
+    bool remove(task<Context> & t)
+    {
+        task<Context> * prev = nullptr;
+        for (auto itr = _head; itr != nullptr; prev = itr, itr = itr->_next)
+        {
+            if (itr != &t)
+                continue;
+            if (prev)
+                prev->_next = t._next;
+            else
+                _head = t._next;
+            if (_tail == &t)
+                _tail = prev;
+            t._next = nullptr;
+            return true;
+        }
+        return false;
+    }
+
+    bool empty() const {return _head == nullptr;}
+};
+
+/**Cooperative round-robin scheduler over tasks.
+ *
+ * Ready tasks are kept in an intrusive FIFO, so enqueue & dequeue are O(1).
+ * A task gets requeued when it yields, blocked tasks stay out of the queue until unblocked
+ * and exited tasks are dropped. The scheduler is not interrupt safe, i.e. unblock must not be called from an ISR.
+ */
+template<typename Context>
+class round_robin
+{
+    task_queue<Context> _ready;
+    task<Context> * _current = nullptr;
+
+    void requeue(task<Context> & t)
+    {
+        if (!t.exited() && !t._blocked)
+            _ready.push(t);
+    }
+
+public:
+    typedef task<Context> task_type;
+    typedef yield_t<void(), Context> yield_type;
+
+    round_robin() = default;
+    round_robin(const round_robin & ) = delete;
+    round_robin& operator=(const round_robin & ) = delete;
+
+    ///Spawns the task, i.e. runs it until it yields the first time, and enqueues it unless it exited or blocked.
+    template<typename Function>
+    void spawn(task_type & t, Function && func)
+    {
+        auto last = _current;
+        _current = &t;
+        t.spawn(static_cast<Function&&>(func));
+        _current = last;
+        requeue(t);
+    }
+
+    ///Resumes the next ready task until it yields. Returns false if no task is ready.
+    bool run_one()
+    {
+        auto t = _ready.pop();
+        if (!t)
+            return false;
+
+        _current = t;
+        t->reenter();
+        _current = nullptr;
+        requeue(*t);
+        return true;
+    }
+
+    ///Runs until no task is ready anymore, i.e. all exited or are blocked.
+    void run()
+    {
+        while (run_one());
+    }
+
+    ///Blocks the current task & yields to the scheduler. It won't be resumed until it gets unblocked.
+    void block(yield_type & yield_)
+    {
+        _current->_blocked = true;
+        yield_();
+    }
+
+    ///Makes a blocked task ready again.
+    void unblock(task_type & t)
+    {
+        if (!t._blocked)
+            return;
+        t._blocked = false;
+        if (&t != _current)
+            _ready.push(t);
+    }
+
+    task_type * current() const {return _current;}
+    bool empty() const {return _ready.empty();}
+};
+
+/**Fixed priority scheduler with up to 32 levels, 31 being the highest.
+ *
+ * Every level is a FIFO & a bitmap marks the non-empty ones, so the highest ready task
+ * is found with a single count-leading-zeros, independent of the number of tasks.
+ *
+ * Without a time slice a yielding task goes to the back of its level. With a time slice it is resumed
+ * again (unless a higher priority task became ready) until `time_slice` ticks have elapsed since it got dispatched.
+ * The ticks are counted by calling tick(), e.g. from the SysTick handler.
+ */
+template<typename Context>
+class priority_scheduler
+{
+    task_queue<Context> _levels[32];
+    std::uint32_t _ready_mask = 0u;
+    task<Context> * _current  = nullptr;
+
+    task<Context> * _slice_owner = nullptr;
+    std::uint32_t _slice_begin   = 0u;
+    std::uint32_t _time_slice    = 0u;
+    volatile std::uint32_t _ticks = 0u;
+
+    void push(task<Context> & t)
+    {
+        _levels[t._priority].push(t);
+        _ready_mask |= (1u << t._priority);
+    }
+
+    void push_front(task<Context> & t)
+    {
+        _levels[t._priority].push_front(t);
+        _ready_mask |= (1u << t._priority);
+    }
+
+    task<Context> * pop()
+    {
+        if (_ready_mask == 0u)
+            return nullptr;
+
+        const auto level = 31u - static_cast<std::uint32_t>(__builtin_clz(_ready_mask));
+        auto t = _levels[level].pop();
+        if (_levels[level].empty())
+            _ready_mask &= ~(1u << level);
+        return t;
+    }
+
+    void requeue(task<Context> & t)
+    {
+        if (t.exited() || t._blocked)
+        {
+            //an exited or blocked task gets a fresh slice, should it be dispatched again.
+            if (&t == _slice_owner)
+                _slice_owner = nullptr;
+            return;
+        }
+
+        if ((_time_slice != 0u) && ((_ticks - _slice_begin) < _time_slice))
+            push_front(t);
+        else
+        {
+            _slice_owner = nullptr;
+            push(t);
+        }
+    }
+
+public:
+    typedef task<Context> task_type;
+    typedef yield_t<void(), Context> yield_type;
+
+    constexpr static std::uint8_t levels = 32u;
+
+    priority_scheduler() = default;
+    priority_scheduler(const priority_scheduler & ) = delete;
+    priority_scheduler& operator=(const priority_scheduler & ) = delete;
+
+    ///Spawns the task with the given priority, i.e. runs it until it yields the first time.
+    template<typename Function>
+    void spawn(task_type & t, std::uint8_t priority, Function && func)
+    {
+        t._priority = priority < levels ? priority : levels - 1u;
+        auto last = _current;
+        _current = &t;
+        t.spawn(static_cast<Function&&>(func));
+        _current = last;
+        if (!t.exited() && !t._blocked)
+            push(t);
+    }
+
+    ///Resumes the highest priority ready task until it yields. Returns false if no task is ready.
+    bool run_one()
+    {
+        auto t = pop();
+        if (!t)
+            return false;
+
+        if (t != _slice_owner)
+        {
+            _slice_owner = t;
+            _slice_begin = _ticks;
+        }
+
+        _current = t;
+        t->reenter();
+        _current = nullptr;
+        requeue(*t);
+        return true;
+    }
+
+    ///Runs until no task is ready anymore, i.e. all exited or are blocked.
+    void run()
+    {
+        while (run_one());
+    }
+
+    ///Blocks the current task & yields to the scheduler. It won't be resumed until it gets unblocked.
+    void block(yield_type & yield_)
+    {
+        _current->_blocked = true;
+        if (_current == _slice_owner)
+            _slice_owner = nullptr;
+        yield_();
+    }
+
+    ///Makes a blocked task ready again.
+    void unblock(task_type & t)
+    {
+        if (!t._blocked)
+            return;
+        t._blocked = false;
+        if (&t != _current)
+            push(t);
+    }
+
+    ///Changes the priority of a suspended task. If it is ready it moves to the back of the new level.
+    void set_priority(task_type & t, std::uint8_t priority)
+    {
+        priority = priority < levels ? priority : levels - 1u;
+        if ((&t != _current) && _levels[t._priority].remove(t))
+        {
+            if (_levels[t._priority].empty())
+                _ready_mask &= ~(1u << t._priority);
+            t._priority = priority;
+            push(t);
+        }
+        else
+            t._priority = priority;
+    }
+
+    ///Sets the time slice in ticks, 0 disables it.
+    void time_slice(std::uint32_t ticks) {_time_slice = ticks;}
+
+    ///Advances the tick counter of the time slice, it is safe to call from an interrupt.
+    void tick() {_ticks = _ticks + 1u;}
+
+    task_type * current() const {return _current;}
+    bool empty() const {return _ready_mask == 0u;}
+};
+
+}
+
+#endif /* EMBO_SCHEDULER_HPP_ */
@@ -0,0 +1,190 @@
+/**
+ * @file   embo/shared_stack.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_SHARED_STACK_HPP_
+#define EMBO_SHARED_STACK_HPP_
+
+#include <embo/coroutine.hpp>
+#include <memory>
+#include <utility>
+
+namespace embo
+{
+
+namespace detail
+{
+namespace coroutine
+{
+
+///The frames of a suspended coroutine, that got copied off the shared stack.
+struct saved_frames
+{
+    std::uintptr_t stack_ptr = 0u;
+    std::unique_ptr<unsigned char[]> buffer;
+    std::size_t capacity = 0u;
+    std::size_t size = 0u;
+};
+
+}
+}
+
+/**One large execution stack, shared by many coroutines (copy-stack mode).
+ *
+ * Only one coroutine is resident at a time. When another one gets resumed, the used part of the resident one,
+ * i.e. from its stack pointer to the end, is copied into its own right-sized buffer & the frames of the resumed one are copied back in.
+ * The resident coroutine stays in place, so back to back resumes of the same coroutine don't copy at all.
+ *
+ * Shared coroutines must be resumed from outside the shared stack, i.e. not by another coroutine on the same stack.
+ */
+class shared_stack
+{
+    std::uint32_t * _data;
+    std::size_t _size;
+    detail::coroutine::saved_frames * _owner = nullptr;
+
+    std::uintptr_t end() const {return reinterpret_cast<std::uintptr_t>(_data + _size);}
+
+    void save(detail::coroutine::saved_frames & f)
+    {
+        f.size = end() - f.stack_ptr;
+        if (f.size > f.capacity)
+        {
+            f.buffer.reset(new unsigned char[f.size]);
+            f.capacity = f.size;
+        }
+        std::memcpy(f.buffer.get(), reinterpret_cast<const void*>(f.stack_ptr), f.size);
+    }
+
+    void restore(detail::coroutine::saved_frames & f)
+    {
+        std::memcpy(reinterpret_cast<void*>(end() - f.size), f.buffer.get(), f.size);
+        f.size = 0u;
+    }
+
+public:
+    template<typename StackContainer>
+    shared_stack(StackContainer & sc) : _data(sc.data()), _size(sc.size()) {}
+
+    template<std::size_t Size>
+    shared_stack(std::uint32_t(&sc)[Size]) : _data(sc), _size(Size) {}
+
+    shared_stack(const shared_stack & ) = delete;
+    shared_stack& operator=(const shared_stack & ) = delete;
+
+    std::uint32_t * data() const {return _data;}
+    std::size_t size() const {return _size;}
+
+    ///Makes the frames resident, evicting the current owner.
+    void acquire(detail::coroutine::saved_frames & f)
+    {
+        if (_owner == &f)
+            return;
+        evict();
+        if (f.size != 0u)
+            restore(f);
+        _owner = &f;
+    }
+
+    ///Copies the resident frames out, so the stack is free.
+    void evict()
+    {
+        if (_owner)
+            save(*_owner);
+        _owner = nullptr;
+    }
+
+    ///Forgets the frames without saving them, e.g. because the coroutine exited.
+    void release(detail::coroutine::saved_frames & f)
+    {
+        if (_owner == &f)
+            _owner = nullptr;
+    }
+
+    bool resident(const detail::coroutine::saved_frames & f) const {return _owner == &f;}
+
+    ///Evicts the current owner & returns the stack, so a new coroutine can be constructed on it.
+    shared_stack & evicted()
+    {
+        evict();
+        return *this;
+    }
+};
+
+/**A coroutine running on a shared_stack.
+ *
+ * It has the interface of a coroutine, except fork, & swaps its frames in & out of the shared stack around every resume.
+ * Since the shared stack tracks it by address, it can neither be copied nor moved.
+ */
+template<typename T = void(), typename Context = default_context>
+class shared_coroutine
+{
+    shared_stack & _stack;
+    detail::coroutine::saved_frames _frames;
+    coroutine<T, Context> _cr;
+
+    //records the stack pointer after the coroutine got suspended.
+    struct suspend_guard
+    {
+        shared_coroutine & cr;
+        ~suspend_guard()
+        {
+            if (cr._cr.exited())
+                cr._stack.release(cr._frames);
+            else
+                cr._frames.stack_ptr = cr._cr.stack_ptr();
+        }
+    };
+
+public:
+    typedef typename coroutine<T, Context>::return_type return_type;
+    typedef typename coroutine<T, Context>::push_type push_type;
+    typedef typename coroutine<T, Context>::yield_type yield_type;
+
+    shared_coroutine(shared_stack & stack) : _stack(stack), _cr(stack.evicted()) {}
+    ~shared_coroutine() {_stack.release(_frames);}
+
+    shared_coroutine(const shared_coroutine & ) = delete;
+    shared_coroutine& operator=(const shared_coroutine & ) = delete;
+
+    template<typename ... Args>
+    auto spawn(Args && ... args) -> decltype(std::declval<coroutine<T, Context>&>().spawn(std::forward<Args>(args)...))
+    {
+        _stack.acquire(_frames);
+        suspend_guard g{*this};
+        return _cr.spawn(std::forward<Args>(args)...);
+    }
+
+    template<typename ... Args>
+    auto reenter(Args && ... args) -> decltype(std::declval<coroutine<T, Context>&>().reenter(std::forward<Args>(args)...))
+    {
+        _stack.acquire(_frames);
+        suspend_guard g{*this};
+        return _cr.reenter(std::forward<Args>(args)...);
+    }
+
+    template<typename ... Args>
+    auto operator()(Args && ... args) -> decltype(std::declval<coroutine<T, Context>&>().reenter(std::forward<Args>(args)...))
+    {
+        return reenter(std::forward<Args>(args)...);
+    }
+
+    bool started() const {return _cr.started();}
+    bool  exited() const {return _cr.exited();}
+
+    ///If the frames are currently on the shared stack.
+    bool resident() const {return _stack.resident(_frames);}
+    ///The bytes of the copied out frames, 0 if resident.
+    std::size_t saved_size() const {return _frames.size;}
+
+    std::uintptr_t stack_ptr () const {return _cr.stack_ptr();}
+    std::size_t   stack_size() const {return _cr.stack_size();}
+    std::size_t   stack_used() const {return _cr.stack_used();}
+};
+
+}
+
+#endif /* EMBO_SHARED_STACK_HPP_ */
@@ -0,0 +1,140 @@
+/**
+ * @file   embo/stack_pool.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_STACK_POOL_HPP_
+#define EMBO_STACK_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+namespace embo
+{
+
+///The default recycle policy of the stack_pool, that leaves released stacks untouched.
+struct no_recycle
+{
+    void operator()(void * , std::size_t ) {}
+};
+
+/**Pool of Count stacks of Size bytes each, that are handed out in O(1).
+ *
+ * Released stacks go into a lock-free free list (a tagged index, so it is safe against ABA),
+ * which makes acquire & release usable from an ISR, as long as std::atomic<std::uint32_t> is lock-free,
+ * i.e. on ARMv7-M and up, but not on ARMv6-M.
+ *
+ * A zero initialized pool is valid, so it can be placed into its own linker section, e.g.
+ * `__attribute__((section(".stacks"))) embo::stack_pool<16, 1024> pool;`
+ * The free list and the bump counter live in the pool object next to the stacks, so that section
+ * must be zeroed by the startup code like .bss. It must not be NOLOAD & left uninitialized.
+ *
+ * Recycle gets called with every released stack before it goes back to the free list,
+ * e.g. embo::madvise_recycle to give the memory of idle stacks back to the OS on hosts.
+ */
+template<std::size_t Count, std::size_t Size, typename Recycle = no_recycle>
+class stack_pool
+{
+    static_assert((Size % 8u) == 0u, "The stack size must keep the 8 byte alignment of the stacks");
+    static_assert((Count > 0u) && (Count < 0xFFFFu), "The pool can hold up to 65534 stacks");
+
+    constexpr static std::uint32_t index_mask = 0xFFFFu;
+
+    alignas(8) std::uint32_t _storage[Count][Size / sizeof(std::uint32_t)];
+    std::atomic<std::uint16_t> _next[Count];
+    std::atomic<std::uint32_t> _free{0u};  //(tag << 16) | (index + 1), 0 is empty
+    std::atomic<std::uint32_t> _fresh{0u}; //stacks that were never handed out start here
+    Recycle _recycle;
+
+    void release(std::uint16_t index)
+    {
+        _recycle(_storage[index], Size);
+
+        auto head = _free.load(std::memory_order_relaxed);
+        std::uint32_t next;
+        do
+        {
+            _next[index].store(static_cast<std::uint16_t>(head & index_mask), std::memory_order_relaxed);
+            next = ((head & ~index_mask) + (index_mask + 1u)) | (index + 1u);
+        }
+        while (!_free.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+public:
+    ///A stack handed out by the pool, that goes back when destroyed. It fulfills the StackContainer of the coroutine.
+    class stack
+    {
+        stack_pool * _pool;
+        std::uint16_t _index;
+
+        stack(stack_pool * pool, std::uint16_t index) : _pool(pool), _index(index) {}
+        friend class stack_pool;
+    public:
+        stack() : _pool(nullptr), _index(0u) {}
+        stack(const stack & ) = delete;
+        stack(stack && lhs) : _pool(lhs._pool), _index(lhs._index) {lhs._pool = nullptr;}
+
+        stack& operator=(const stack & ) = delete;
+        stack& operator=(stack && lhs)
+        {
+            if (this != &lhs)
+            {
+                release();
+                _pool  = lhs._pool;
+                _index = lhs._index;
+                lhs._pool = nullptr;
+            }
+            return *this;
+        }
+
+        ~stack() {release();}
+
+        ///Gives the stack back to the pool, before the handle is destroyed.
+        void release()
+        {
+            if (_pool)
+                _pool->release(_index);
+            _pool = nullptr;
+        }
+
+        std::uint32_t * data() const {return _pool ? _pool->_storage[_index] : nullptr;}
+        constexpr static std::size_t size() {return Size / sizeof(std::uint32_t);}
+
+        explicit operator bool() const {return _pool != nullptr;}
+    };
+
+    stack_pool() = default;
+    stack_pool(const stack_pool & ) = delete;
+    stack_pool& operator=(const stack_pool & ) = delete;
+
+    ///Takes a stack from the pool. The returned handle is empty if all stacks are in use.
+    stack acquire()
+    {
+        auto head = _free.load(std::memory_order_acquire);
+        while ((head & index_mask) != 0u)
+        {
+            const auto index = static_cast<std::uint16_t>((head & index_mask) - 1u);
+            const std::uint32_t next = (head & ~index_mask) | _next[index].load(std::memory_order_relaxed);
+            if (_free.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+                return stack(this, index);
+        }
+
+        auto fresh = _fresh.load(std::memory_order_relaxed);
+        while (fresh < Count)
+        {
+            if (_fresh.compare_exchange_weak(fresh, fresh + 1u, std::memory_order_relaxed, std::memory_order_relaxed))
+                return stack(this, static_cast<std::uint16_t>(fresh));
+        }
+        return stack();
+    }
+
+    constexpr static std::size_t count() {return Count;}
+    constexpr static std::size_t stack_size() {return Size;}
+};
+
+}
+
+#endif /* EMBO_STACK_POOL_HPP_ */
@@ -0,0 +1,196 @@
+/**
+ * @file   embo/timer.hpp
+ * @date   17.10.2026
+ * @author Klemens D. Morgenstern
+ *
+ * Published under [Apache License 2.0](http://www.apache.org/licenses/LICENSE-2.0.html)
+ */
+#ifndef EMBO_TIMER_HPP_
+#define EMBO_TIMER_HPP_
+
+#include <embo/scheduler.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#endif
+
+namespace embo
+{
+
+/**A clock is a type with a static `now()` returning the current tick as std::uint32_t.
+ *
+ * The systick_clock counts the ticks of the SysTick handler, which has to call systick_clock::tick().
+ */
+struct systick_clock
+{
+    static std::uint32_t now() {return counter();}
+    static void tick() {counter() = counter() + 1u;}
+private:
+    static volatile std::uint32_t & counter()
+    {
+        static volatile std::uint32_t ticks = 0u;
+        return ticks;
+    }
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+///Host clock, ticking in milliseconds.
+struct monotonic_clock
+{
+    static std::uint32_t now()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::uint32_t>(ts.tv_sec * 1000u + ts.tv_nsec / 1000000);
+    }
+};
+#endif
+
+/**Hierarchical timer wheel, that suspends tasks of a scheduler until a deadline.
+ *
+ * Every level has 2^SlotBits slots, level 0 holds the deadlines of the current round,
+ * higher levels get cascaded down when the lower ones wrap around. Insert and expiry are O(1),
+ * the timer node lives in the frame of the sleeping task, so nothing is allocated.
+ *
+ * poll() must be called from the main loop, it expires the timers up to the current tick.
+ * It steps through the ticks one by one only while level 0 holds timers, otherwise it jumps
+ * to the next tick, where the lowest occupied level gets cascaded. So a long idle costs
+ * O(Levels * slots) steps at most & an empty wheel catches up at once.
+ * A sleeping task must only be woken up by the timer wheel.
+ */
+template<typename Scheduler, typename Clock, unsigned SlotBits = 6u, unsigned Levels = 4u>
+class timer_wheel
+{
+    static_assert((SlotBits * Levels) <= 32u, "The wheel can't cover more than 32 bit");
+
+    struct node
+    {
+        node * next;
+        std::uint32_t deadline;
+        typename Scheduler::task_type * task;
+    };
+
+    constexpr static std::uint32_t slots = 1u << SlotBits;
+    constexpr static std::uint32_t mask  = slots - 1u;
+
+    Scheduler & _sched;
+    std::uint32_t _now;
+    node * _wheel[Levels][slots] = {};
+    std::uint32_t _count[Levels] = {};
+
+    static std::uint32_t above(std::uint32_t value, unsigned level)
+    {
+        return (SlotBits * (level + 1u)) >= 32u ? 0u : (value >> (SlotBits * (level + 1u)));
+    }
+
+    void insert(node & n)
+    {
+        //due or late timers go into the current slot.
+        const std::uint32_t deadline = (static_cast<std::int32_t>(n.deadline - _now) <= 0) ? _now : n.deadline;
+
+        //the lowest level, where deadline & now only differ in the slot bits.
+        unsigned level = 0u;
+        while ((level < Levels) && (above(deadline ^ _now, level) != 0u))
+            level++;
+
+        //beyond the range of the wheel the top level slot comes around before the deadline & the timer gets reinserted.
+        if (level == Levels)
+            level = Levels - 1u;
+
+        const auto slot = (deadline >> (SlotBits * level)) & mask;
+        n.next = _wheel[level][slot];
+        _wheel[level][slot] = &n;
+        _count[level]++;
+    }
+
+    void cascade(unsigned level)
+    {
+        auto & slot = _wheel[level][(_now >> (SlotBits * level)) & mask];
+        auto n = slot;
+        slot = nullptr;
+        while (n)
+        {
+            auto next = n->next;
+            _count[level]--;
+            insert(*n);
+            n = next;
+        }
+    }
+
+    void expire()
+    {
+        auto & slot = _wheel[0][_now & mask];
+        auto n = slot;
+        slot = nullptr;
+        while (n)
+        {
+            auto next = n->next;
+            _count[0]--;
+            _sched.unblock(*n->task);
+            n = next;
+        }
+    }
+
+    //the ticks until the next one, where a cascade or an expiry can happen.
+    std::uint32_t idle() const
+    {
+        unsigned level = 0u;
+        while ((level < Levels) && (_count[level] == 0u))
+            level++;
+        if (level == 0u)
+            return 0u;
+        if (level == Levels)
+            return ~std::uint32_t();
+        const std::uint32_t span_mask = (1u << (SlotBits * level)) - 1u;
+        return span_mask - (_now & span_mask);
+    }
+
+public:
+    typedef typename Scheduler::yield_type yield_type;
+
+    timer_wheel(Scheduler & sched) : _sched(sched), _now(Clock::now()) {}
+    timer_wheel(const timer_wheel & ) = delete;
+    timer_wheel& operator=(const timer_wheel & ) = delete;
+
+    ///Suspends the current task of the scheduler until the deadline. Returns immediately if it has passed.
+    void sleep_until(yield_type & yield_, std::uint32_t deadline)
+    {
+        if (static_cast<std::int32_t>(deadline - Clock::now()) <= 0)
+            return;
+
+        node n{nullptr, deadline, _sched.current()};
+        insert(n);
+        _sched.block(yield_);
+    }
+
+    void sleep_for(yield_type & yield_, std::uint32_t ticks)
+    {
+        sleep_until(yield_, Clock::now() + ticks);
+    }
+
+    ///Advances the wheel to the current tick & unblocks the expired tasks.
+    void poll()
+    {
+        const auto now = Clock::now();
+        while (_now != now)
+        {
+            const auto skip = idle();
+            if (skip >= (now - _now))
+            {
+                _now = now;
+                break;
+            }
+            _now += skip + 1u;
+            unsigned level = 1u;
+            while ((level < Levels) && ((_now & ((1u << (SlotBits * level)) - 1u)) == 0u))
+                level++;
+            while (--level > 0u)
+                cascade(level);
+            expire();
+        }
+    }
+};
+
+}
+
+#endif /* EMBO_TIMER_HPP_ */
@@ -7,7 +7,24 @@
  */
 
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <embo/coroutine.hpp>
+#include <embo/scheduler.hpp>
+#include <embo/timer.hpp>
+#include <embo/stack_pool.hpp>
+#include <embo/shared_stack.hpp>
+#include <embo/channel.hpp>
+#include <embo/batch.hpp>
+#include <embo/generator.hpp>
+#include <embo/parser.hpp>
+#include <algorithm>
+#include <numeric>
+
+#if defined(__linux__)
+#include <embo/mmap_stack.hpp>
+#include <thread>
+#endif
 
 static std::size_t test_cnt = 0;
 #define TEST_REPORT() test_cnt
@@ -92,7 +109,7 @@ void simple_stack()
 
     {
         volatile auto sl = cr.stack_left();
-        auto se = reinterpret_cast<std::uint32_t>(stack + 127);
+        auto se = reinterpret_cast<std::uintptr_t>(stack + 127);
         TEST_ASSERT_EQUAL(sl, 127*4);
         sl = cr.stack_ptr() ; TEST_ASSERT_EQUAL(sl, se);
         sl = cr.stack_size(); TEST_ASSERT_EQUAL(sl, 128*4);
@@ -356,6 +373,1239 @@ void push_pull_64()
     TEST_ASSERT_EQUAL(val, 19);
 }
 
+struct large_value
+{
+    std::int32_t data[8];
+};
+
+void push_pull_large()
+{
+    std::uint32_t stack[256];
+    embo::coroutine<large_value(large_value)> cr{stack};
+
+    auto f = [](embo::yield_t<large_value(large_value)> yield_)
+        {
+            auto val = yield_(large_value{{1, 2, 3, 4, 5, 6, 7, 8}});
+            TEST_ASSERT_EQUAL(val.data[0], 10);
+            TEST_ASSERT_EQUAL(val.data[7], 80);
+            val.data[0]++;
+            val = yield_(val);
+            TEST_ASSERT_EQUAL(val.data[3], 42);
+            return val;
+        };
+
+    auto val = cr.spawn(f);
+    TEST_ASSERT_EQUAL(val.data[0], 1);
+    TEST_ASSERT_EQUAL(val.data[7], 8);
+
+    val = cr.reenter(large_value{{10, 20, 30, 40, 50, 60, 70, 80}});
+    TEST_ASSERT_EQUAL(val.data[0], 11);
+    TEST_ASSERT_EQUAL(val.data[7], 80);
+
+    val.data[3] = 42;
+    val = cr.reenter(val);
+    TEST_ASSERT_EQUAL(val.data[3], 42);
+    TEST_ASSERT_EQUAL(val.data[0], 11);
+    TEST_ASSERT(cr.exited());
+}
+
+struct record
+{
+    std::uint32_t timestamp;
+    std::uint16_t id;
+    std::uint16_t flags;
+};
+
+struct packet
+{
+    const char * data;
+    std::uint32_t size;
+    std::uint32_t crc;
+    std::uint32_t seq;
+};
+
+#if defined(__arm__)
+//both travel in a1-a4, the record as the initial value too, since it fits into a3-a4.
+static_assert(embo::detail::coroutine::select_path<embo::default_context, packet, record, false>()
+              == embo::detail::coroutine::switch_path::payload, "packet & record are register payloads");
+static_assert(std::is_same<embo::detail::coroutine::make_transfer_t<record>, std::uint64_t>::value, "record is passed in a3-a4");
+static_assert(std::is_same<embo::detail::coroutine::make_transfer_t<packet>, packet*>::value, "packet is too large for a3-a4");
+//the executor must not take fp types, the hard-float abi would expect them in the fp registers.
+static_assert(std::is_same<embo::detail::coroutine::make_transfer_t<double>, std::uint64_t>::value, "double is passed in a3-a4");
+#endif
+
+void push_pull_record()
+{
+    std::uint32_t stack[256];
+    embo::coroutine<packet(record)> cr{stack};
+
+    auto f = [](embo::yield_t<packet(record)> yield_, record rec)
+        {
+            TEST_ASSERT_EQUAL(rec.timestamp, 1000u);
+            TEST_ASSERT_EQUAL(rec.id, 7);
+            rec = yield_(packet{"abc", 3u, 0xDEADBEEFu, rec.timestamp});
+            TEST_ASSERT_EQUAL(rec.timestamp, 2000u);
+            TEST_ASSERT_EQUAL(rec.flags, 0x55);
+            return packet{"de", 2u, rec.flags, rec.timestamp};
+        };
+
+    auto pk = cr.spawn(f, record{1000u, 7u, 0u});
+    TEST_ASSERT_EQUAL(pk.size, 3u);
+    TEST_ASSERT_EQUAL(pk.crc, 0xDEADBEEFu);
+    TEST_ASSERT_EQUAL(pk.seq, 1000u);
+    TEST_ASSERT_EQUAL(pk.data[2], 'c');
+
+    pk = cr.reenter(record{2000u, 8u, 0x55u});
+    TEST_ASSERT_EQUAL(pk.size, 2u);
+    TEST_ASSERT_EQUAL(pk.crc, 0x55u);
+    TEST_ASSERT_EQUAL(pk.seq, 2000u);
+    TEST_ASSERT(cr.exited());
+}
+
+void push_pull_float()
+{
+    std::uint32_t stack[2048];
+    embo::coroutine<float(double)> cr{stack};
+
+    auto f = [](embo::yield_t<float(double)> yield_, double d)
+        {
+            TEST_ASSERT(d == 0.125);
+            d = yield_(1.5f);
+            TEST_ASSERT(d == -3.75);
+            return static_cast<float>(d) + 1.0f;
+        };
+
+    auto val = cr.spawn(f, 0.125);
+    TEST_ASSERT(val == 1.5f);
+    val = cr.reenter(-3.75);
+    TEST_ASSERT(val == -2.75f);
+    TEST_ASSERT(cr.exited());
+
+    embo::coroutine<double(float)> cr2{stack};
+    auto g = [](embo::yield_t<double(float)> yield_, float x)
+        {
+            x = yield_(x * 2.0);
+            return x - 0.5;
+        };
+
+    auto d = cr2.spawn(g, 2.5f);
+    TEST_ASSERT(d == 5.0);
+    d = cr2.reenter(4.0f);
+    TEST_ASSERT(d == 3.5);
+    TEST_ASSERT(cr2.exited());
+}
+
+void pull_move_only()
+{
+    std::uint32_t stack[2048];
+    embo::coroutine<std::unique_ptr<int>()> cr{stack};
+
+    auto f = [](embo::yield_t<std::unique_ptr<int>()> yield_)
+        {
+            yield_(std::unique_ptr<int>(new int(42)));
+            std::unique_ptr<int> p{new int(24)};
+            yield_(std::move(p));
+            TEST_ASSERT(!p);
+            return std::unique_ptr<int>(new int(78));
+        };
+
+    auto val = cr.spawn(f); TEST_ASSERT(val && (*val == 42));
+    val = cr.reenter();     TEST_ASSERT(val && (*val == 24));
+    val = cr.reenter();     TEST_ASSERT(val && (*val == 78));
+    TEST_ASSERT(cr.exited());
+}
+
+void push_move_only()
+{
+    std::uint32_t stack[2048];
+    embo::coroutine<void(std::unique_ptr<int>)> cr{stack};
+
+    int sum = 0;
+    auto f = [&](embo::yield_t<void(std::unique_ptr<int>)> yield_, std::unique_ptr<int> input)
+        {
+            sum += *input;
+            auto p = yield_();
+            sum += *p;
+            p = yield_();
+            sum += *p;
+        };
+
+    cr.spawn(f, std::unique_ptr<int>(new int(1)));
+    cr.reenter(std::unique_ptr<int>(new int(20)));
+    TEST_ASSERT(!cr.exited());
+    cr.reenter(std::unique_ptr<int>(new int(300)));
+    TEST_ASSERT(cr.exited());
+    TEST_ASSERT_EQUAL(sum, 321);
+}
+
+void fpu_pull()
+{
+    std::uint32_t stack[256];
+    embo::coroutine<std::int32_t(), embo::fpu_context> cr{stack};
+
+    auto f = [](embo::yield_t<std::int32_t(), embo::fpu_context> yield_)
+         {
+            volatile float x = 1.5f;
+            float y = x * 3.0f;
+            yield_(static_cast<std::int32_t>(y));
+            y = y * x;
+            yield_(static_cast<std::int32_t>(y * 2.0f));
+            return static_cast<std::int32_t>(y + x);
+         };
+
+    volatile float a = 0.25f;
+    float b = a * 8.0f;
+    volatile auto val = cr.spawn(f); TEST_ASSERT_EQUAL(val, 4);
+    b = b + a;
+    val = cr.reenter(); TEST_ASSERT_EQUAL(val, 13);
+    TEST_ASSERT(b == 2.25f);
+    val = cr.reenter(); TEST_ASSERT_EQUAL(val, 8);
+    TEST_ASSERT(b == 2.25f);
+    TEST_ASSERT(cr.exited());
+}
+
+void inline_push_pull()
+{
+    std::uint32_t stack[256];
+    embo::coroutine<std::int64_t(std::int32_t), embo::inline_context> cr{stack};
+
+    auto f = [](embo::yield_t<std::int64_t(std::int32_t), embo::inline_context> yield_)
+        {
+            volatile int i = 13;
+            std::int64_t val = yield_(0x1234567890ABCDEFll);
+            TEST_ASSERT_EQUAL(val, 7);
+            TEST_ASSERT_EQUAL(i, 13);
+            val = yield_(val + 0x100000000ll);
+            TEST_ASSERT_EQUAL(val, 24);
+            TEST_ASSERT_EQUAL(i, 13);
+            return val - 5;
+        };
+
+    volatile int j = 42;
+    std::int64_t val = cr.spawn(f);
+    TEST_ASSERT_EQUAL(val, 0x1234567890ABCDEFll);
+    val = cr.reenter(7);
+    TEST_ASSERT_EQUAL(val, 0x100000007ll);
+    TEST_ASSERT_EQUAL(j, 42);
+    val = cr.reenter(24);
+    TEST_ASSERT_EQUAL(val, 19);
+    TEST_ASSERT_EQUAL(j, 42);
+    TEST_ASSERT(cr.exited());
+}
+
+#if defined(__aarch64__)
+void push_pull_128()
+{
+    using uint128 = unsigned __int128;
+    const uint128 big = (static_cast<uint128>(0x1234567890ABCDEFull) << 64) | 0xFEDCBA0987654321ull;
+
+    std::uint64_t stack[256];
+    embo::coroutine<uint128(uint128)> cr{stack};
+
+    auto f = +[](embo::yield_t<uint128(uint128)> yield_)
+        {
+            const uint128 big = (static_cast<uint128>(0x1234567890ABCDEFull) << 64) | 0xFEDCBA0987654321ull;
+            auto val = yield_(big);
+            TEST_ASSERT(val == big + 1);
+            return val << 1;
+        };
+
+    auto val = cr.spawn(f);
+    TEST_ASSERT(val == big);
+    val = cr.reenter(val + 1);
+    TEST_ASSERT(val == ((big + 1) << 1));
+    TEST_ASSERT(cr.exited());
+}
+#endif
+
+//homogeneous floating-point aggregates are passed in v0-v3 on aarch64 & s0-s3 on arm hard-float.
+struct vec2 {float x, y;};
+struct vec4 {float x, y, z, w;};
+
+#if defined(__arm__)
+static_assert(std::is_same<embo::detail::coroutine::make_transfer_t<vec2>, std::uint64_t>::value, "vec2 is passed in a3-a4");
+#endif
+
+void push_pull_hfa()
+{
+    std::uint32_t stack[2048];
+    embo::coroutine<vec4(vec2)> cr{stack};
+
+    auto f = [](embo::yield_t<vec4(vec2)> yield_, vec2 v)
+        {
+            TEST_ASSERT((v.x == 1.0f) && (v.y == 2.0f));
+            v = yield_(vec4{v.x, v.y, 3.0f, 4.0f});
+            TEST_ASSERT((v.x == -1.0f) && (v.y == 0.5f));
+            return vec4{v.y, v.x, 0.25f, 8.0f};
+        };
+
+    auto val = cr.spawn(f, vec2{1.0f, 2.0f});
+    TEST_ASSERT((val.x == 1.0f) && (val.y == 2.0f) && (val.z == 3.0f) && (val.w == 4.0f));
+    val = cr.reenter(vec2{-1.0f, 0.5f});
+    TEST_ASSERT((val.x == 0.5f) && (val.y == -1.0f) && (val.z == 0.25f) && (val.w == 8.0f));
+    TEST_ASSERT(cr.exited());
+}
+
+void round_robin()
+{
+    static std::uint32_t stack_a[256], stack_b[256], stack_c[256];
+    static embo::round_robin<> sched;
+    embo::task<> a{stack_a}, b{stack_b}, c{stack_c};
+
+    static char trace[16];
+    static std::size_t pos = 0u;
+
+    sched.spawn(a, [](embo::yield_t<void()> yield_)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                trace[pos++] = 'a';
+                yield_();
+            }
+        });
+    sched.spawn(b, [](embo::yield_t<void()> yield_)
+        {
+            trace[pos++] = 'b';
+            sched.block(yield_);
+            trace[pos++] = 'B';
+        });
+    sched.spawn(c, [&](embo::yield_t<void()> yield_)
+        {
+            trace[pos++] = 'c';
+            yield_();
+            TEST_ASSERT(b.blocked());
+            sched.unblock(b);
+            trace[pos++] = 'C';
+        });
+
+    TEST_ASSERT(b.blocked());
+    sched.run();
+    trace[pos] = '\0';
+
+    TEST_ASSERT(std::strcmp(trace, "abcaCaB") == 0);
+    TEST_ASSERT(a.exited());
+    TEST_ASSERT(b.exited());
+    TEST_ASSERT(c.exited());
+    TEST_ASSERT(sched.empty());
+}
+
+void priority_scheduler()
+{
+    static std::uint32_t stack_lo[256], stack_mid[256], stack_hi[256];
+    static embo::priority_scheduler<> sched;
+    embo::task<> lo{stack_lo}, mid{stack_mid}, hi{stack_hi};
+
+    static char trace[16];
+    static std::size_t pos = 0u;
+
+    sched.spawn(lo, 1u, [](embo::yield_t<void()> yield_)
+        {
+            yield_();
+            trace[pos++] = 'l';
+            yield_();
+            trace[pos++] = 'l';
+        });
+    sched.spawn(mid, 5u, [](embo::yield_t<void()> yield_)
+        {
+            sched.block(yield_);
+            trace[pos++] = 'm';
+        });
+    sched.spawn(hi, 31u, [&](embo::yield_t<void()> yield_)
+        {
+            yield_();
+            trace[pos++] = 'h';
+            sched.block(yield_);
+            trace[pos++] = 'H';
+        });
+
+    //lo gets raised above mid, while suspended.
+    sched.set_priority(lo, 7u);
+    TEST_ASSERT_EQUAL(lo.priority(), 7u);
+
+    TEST_ASSERT(sched.run_one()); //hi
+    TEST_ASSERT(sched.run_one()); //lo
+    sched.unblock(mid);
+    sched.unblock(hi);
+    sched.run();
+    trace[pos] = '\0';
+
+    TEST_ASSERT(std::strcmp(trace, "hlHlm") == 0);
+    TEST_ASSERT(lo.exited());
+    TEST_ASSERT(mid.exited());
+    TEST_ASSERT(hi.exited());
+    TEST_ASSERT(sched.empty());
+
+    //with a time slice a task keeps running until the slice is used up.
+    embo::task<> a{stack_lo}, b{stack_mid};
+    pos = 0u;
+    sched.time_slice(2u);
+    sched.spawn(a, 3u, [&](embo::yield_t<void()> yield_)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                trace[pos++] = 'a';
+                sched.tick();
+                yield_();
+            }
+        });
+    sched.spawn(b, 3u, [&](embo::yield_t<void()> yield_)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                trace[pos++] = 'b';
+                sched.tick();
+                yield_();
+            }
+        });
+    sched.run();
+    trace[pos] = '\0';
+    TEST_ASSERT(std::strcmp(trace, "abaabb") == 0);
+
+    //a task that blocked starts a new slice once it gets unblocked.
+    embo::task<> c{stack_lo}, d{stack_mid};
+    pos = 0u;
+    sched.spawn(c, 3u, [&](embo::yield_t<void()> yield_)
+        {
+            yield_();
+            sched.block(yield_);
+            trace[pos++] = 'c';
+            sched.tick();
+            yield_();
+            trace[pos++] = 'c';
+        });
+    TEST_ASSERT(sched.run_one()); //c blocks
+    TEST_ASSERT(!sched.run_one());
+    sched.tick();
+    sched.tick();
+    sched.tick();
+    sched.unblock(c);
+    sched.spawn(d, 3u, [&](embo::yield_t<void()> yield_)
+        {
+            yield_();
+            trace[pos++] = 'd';
+        });
+    sched.run();
+    trace[pos] = '\0';
+    TEST_ASSERT(std::strcmp(trace, "ccd") == 0);
+    TEST_ASSERT(c.exited());
+    TEST_ASSERT(d.exited());
+}
+
+struct test_clock
+{
+    static std::uint32_t ticks;
+    static std::uint32_t now() {return ticks;}
+};
+
+std::uint32_t test_clock::ticks = 0xFFFFFF00u; //close to the wrap around
+
+void timer_wheel()
+{
+    static std::uint32_t stack_a[256], stack_b[256], stack_c[256];
+    static embo::round_robin<> sched;
+    static embo::timer_wheel<embo::round_robin<>, test_clock> wheel{sched};
+    embo::task<> a{stack_a}, b{stack_b}, c{stack_c};
+
+    static std::uint32_t woken[3][3];
+    static std::size_t cnt[3];
+
+    sched.spawn(a, [](embo::yield_t<void()> yield_)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                wheel.sleep_for(yield_, 10u);
+                woken[0][cnt[0]++] = test_clock::now();
+            }
+        });
+    sched.spawn(b, [](embo::yield_t<void()> yield_)
+        {
+            const auto begin = test_clock::now();
+            wheel.sleep_until(yield_, begin + 100u);
+            woken[1][cnt[1]++] = test_clock::now() - begin;
+            wheel.sleep_for(yield_, 5000u);
+            woken[1][cnt[1]++] = test_clock::now() - begin;
+        });
+    sched.spawn(c, [](embo::yield_t<void()> yield_)
+        {
+            wheel.sleep_for(yield_, 0u); //already due
+            woken[2][cnt[2]++] = test_clock::now();
+            wheel.sleep_for(yield_, 300000u);
+            woken[2][cnt[2]++] = test_clock::now();
+        });
+
+    const auto begin = test_clock::now();
+    TEST_ASSERT(a.blocked());
+    TEST_ASSERT(b.blocked());
+    TEST_ASSERT(c.blocked());
+
+    while (!(a.exited() && b.exited() && c.exited()) && (test_clock::ticks - begin) < 400000u)
+    {
+        test_clock::ticks++;
+        wheel.poll();
+        sched.run();
+    }
+
+    TEST_ASSERT_EQUAL(cnt[0], 3u);
+    TEST_ASSERT_EQUAL(woken[0][0] - begin, 10u);
+    TEST_ASSERT_EQUAL(woken[0][2] - begin, 30u);
+    TEST_ASSERT_EQUAL(cnt[1], 2u);
+    TEST_ASSERT_EQUAL(woken[1][0], 100u);
+    TEST_ASSERT_EQUAL(woken[1][1], 5100u);
+    TEST_ASSERT_EQUAL(cnt[2], 2u);
+    TEST_ASSERT_EQUAL(woken[2][0], begin);
+    TEST_ASSERT_EQUAL(woken[2][1] - begin, 300000u);
+}
+
+//a deadline beyond the 24 bit range of the wheel, reached by a few polls across long idle times.
+void timer_wheel_idle()
+{
+    static std::uint32_t stack_a[256], stack_b[256];
+    embo::round_robin<> sched;
+    embo::timer_wheel<embo::round_robin<>, test_clock> wheel{sched};
+    embo::task<> a{stack_a}, b{stack_b};
+
+    constexpr std::uint32_t far  = (1u << 24) + 12345u;
+    constexpr std::uint32_t near = 70000u;
+    const auto begin = test_clock::now();
+    std::uint32_t woken_a = 0u, woken_b = 0u;
+
+    sched.spawn(a, [&](embo::yield_t<void()> yield_)
+        {
+            wheel.sleep_for(yield_, far);
+            woken_a = test_clock::now() - begin;
+        });
+    sched.spawn(b, [&](embo::yield_t<void()> yield_)
+        {
+            wheel.sleep_for(yield_, near);
+            woken_b = test_clock::now() - begin;
+        });
+
+    auto poll_at = [&](std::uint32_t offset)
+        {
+            test_clock::ticks = begin + offset;
+            wheel.poll();
+            sched.run();
+        };
+
+    poll_at(near - 1u);
+    TEST_ASSERT(b.blocked());
+    poll_at(near);
+    TEST_ASSERT(b.exited());
+    TEST_ASSERT_EQUAL(woken_b, near);
+
+    poll_at(1u << 23);
+    poll_at(far - 1u);
+    TEST_ASSERT(a.blocked());
+    poll_at(far);
+    TEST_ASSERT(a.exited());
+    TEST_ASSERT_EQUAL(woken_a, far);
+
+    //an empty wheel catches up at once.
+    poll_at(far + 0x40000000u);
+}
+
+void stack_pool()
+{
+    static embo::stack_pool<3, 1024> pool;
+
+    auto s1 = pool.acquire();
+    auto s2 = pool.acquire();
+    auto s3 = pool.acquire();
+    TEST_ASSERT(s1 && s2 && s3);
+    TEST_ASSERT(!pool.acquire());
+    TEST_ASSERT((reinterpret_cast<std::uintptr_t>(s2.data()) % 8u) == 0u);
+    TEST_ASSERT(s1.data() != s2.data());
+
+    auto p2 = s2.data();
+    s2.release();
+    TEST_ASSERT(!s2);
+
+    auto s4 = pool.acquire();
+    TEST_ASSERT(s4.data() == p2);
+    TEST_ASSERT(!pool.acquire());
+
+    {
+        auto moved = std::move(s1);
+        TEST_ASSERT(!s1);
+        embo::coroutine<int()> cr{moved};
+        auto val = cr.spawn([](embo::yield_t<int()> yield_) {yield_(1); return 2;});
+        TEST_ASSERT_EQUAL(val, 1);
+        TEST_ASSERT_EQUAL(cr.reenter(), 2);
+        TEST_ASSERT_EQUAL(cr.stack_size(), 1024u);
+    }
+
+    auto s5 = pool.acquire(); //the one released by moved
+    TEST_ASSERT(s5);
+    TEST_ASSERT(!pool.acquire());
+}
+
+__attribute__((noinline)) void use_stack()
+{
+    volatile std::uint32_t buffer[100];
+    for (auto & b : buffer)
+        b = 0u;
+}
+
+void stack_high_water()
+{
+    std::uint32_t stack[512];
+    embo::coroutine<void()> cr{stack};
+    cr.paint_stack();
+    TEST_ASSERT(cr.stack_high_water() <= sizeof(std::uint32_t));
+
+    cr.spawn(+[](embo::yield_t<void()> yield_)
+        {
+            use_stack();
+            yield_();
+            yield_();
+        });
+
+    //the peak is kept, even though the coroutine is suspended at a lower depth.
+    const auto peak = cr.stack_high_water();
+    TEST_ASSERT(peak >= sizeof(std::uint32_t) * 100u);
+    TEST_ASSERT(peak < sizeof(stack));
+    TEST_ASSERT(peak > cr.stack_used());
+
+    //repainting resets the mark to the current depth.
+    cr.paint_stack();
+    TEST_ASSERT(cr.stack_high_water() < peak);
+    TEST_ASSERT(cr.stack_high_water() >= cr.stack_used());
+    cr.reenter();
+    cr.reenter();
+    TEST_ASSERT(cr.exited());
+}
+
+void shared_stack()
+{
+    static std::uint32_t stack[4096];
+    embo::shared_stack shared{stack};
+
+    embo::shared_coroutine<int(int)> a{shared}, b{shared};
+
+    auto f = [](embo::yield_t<int(int)> yield_, int offset)
+        {
+            volatile int local[8] = {offset, offset, offset, offset, offset, offset, offset, offset};
+            int sum = offset;
+            for (int i = 0; i < 3; i++)
+                sum += yield_(sum) + local[i];
+            return sum;
+        };
+
+    TEST_ASSERT_EQUAL(a.spawn(f, 100), 100);
+    TEST_ASSERT(a.resident());
+    TEST_ASSERT_EQUAL(b.spawn(f, 1000), 1000);
+    TEST_ASSERT(b.resident());
+    TEST_ASSERT(!a.resident());
+
+    //only the used part got saved.
+    TEST_ASSERT(a.saved_size() > 0u);
+    TEST_ASSERT(a.saved_size() < 1024u);
+
+    TEST_ASSERT_EQUAL(a.reenter(1), 201);
+    TEST_ASSERT(a.resident());
+    TEST_ASSERT_EQUAL(a.saved_size(), 0u);
+    TEST_ASSERT_EQUAL(a.reenter(2), 303); //back to back, no copy
+    TEST_ASSERT(b.saved_size() > 0u);
+
+    TEST_ASSERT_EQUAL(b.reenter(3), 2003);
+    TEST_ASSERT_EQUAL(a.reenter(4), 407);
+    TEST_ASSERT(a.exited());
+    TEST_ASSERT(!a.resident());
+    TEST_ASSERT_EQUAL(b.reenter(5), 3008);
+    TEST_ASSERT_EQUAL(b.reenter(6), 4014);
+    TEST_ASSERT(b.exited());
+}
+
+int fork_count(embo::yield_t<int()> & yield_)
+{
+    int sum = 0;
+    for (int i = 1; i < 4; i++)
+    {
+        yield_(sum);
+        sum += i;
+    }
+    return sum;
+}
+
+struct fork_state
+{
+    int values[4];
+    int * cursor;
+};
+
+void fork_relocate()
+{
+    static std::uint32_t parent_stack[1024], child_stack[1024], small_stack[4];
+
+    {
+        embo::coroutine<int()> cr{parent_stack}, child{child_stack};
+        TEST_ASSERT_EQUAL(cr.spawn([](embo::yield_t<int()> yield_) {return fork_count(yield_);}), 0);
+        TEST_ASSERT_EQUAL(cr.reenter(), 1);
+
+        TEST_ASSERT(cr.fork(child));
+        TEST_ASSERT(child.started());
+        TEST_ASSERT_EQUAL(child.stack_used(), cr.stack_used());
+
+        TEST_ASSERT_EQUAL(cr.reenter(), 3);
+        TEST_ASSERT_EQUAL(cr.reenter(), 6);
+        TEST_ASSERT(cr.exited());
+        TEST_ASSERT(!child.exited());
+
+        TEST_ASSERT_EQUAL(child.reenter(), 3);
+        TEST_ASSERT_EQUAL(child.reenter(), 6);
+        TEST_ASSERT(child.exited());
+
+        embo::coroutine<int()> tiny{small_stack};
+        TEST_ASSERT(!cr.fork(tiny));
+    }
+
+    {
+        fork_state * state = nullptr;
+        embo::coroutine<int()> cr{parent_stack}, child{child_stack};
+        cr.spawn([&](embo::yield_t<int()> yield_)
+            {
+                fork_state st{{1, 2, 3, 4}, nullptr};
+                state = &st;
+                for (st.cursor = st.values; st.cursor != st.values + 3; )
+                    yield_(*st.cursor++);
+                return *st.cursor;
+            });
+
+        TEST_ASSERT(cr.fork(child,
+                [&](const embo::fork_relocation & r)
+                {
+                    embo::fork_rebase_all{}(r);
+                    TEST_ASSERT(r.contains(reinterpret_cast<std::uintptr_t>(state)));
+                    r(state)->values[1] = 20;
+                    r(state)->values[3] = 40;
+                }));
+
+        TEST_ASSERT_EQUAL(cr.reenter(), 2);
+        TEST_ASSERT_EQUAL(child.reenter(), 20);
+        TEST_ASSERT_EQUAL(child.reenter(), 3);
+        TEST_ASSERT_EQUAL(cr.reenter(), 3);
+        TEST_ASSERT_EQUAL(cr.reenter(), 4);
+        TEST_ASSERT_EQUAL(child.reenter(), 40);
+        TEST_ASSERT(cr.exited());
+        TEST_ASSERT(child.exited());
+    }
+}
+
+void transfer_to()
+{
+    static std::uint32_t stacks[3][1024];
+
+    //producer -> filter -> consumer, every hop a single switch.
+    {
+        int slot = 0;
+        int received[4] = {};
+        int count = 0;
+        embo::coroutine<void()> producer{stacks[0]}, filter{stacks[1]}, consumer{stacks[2]};
+
+        consumer.spawn([&](embo::yield_t<void()> yield_)
+            {
+                yield_();
+                while (true)
+                {
+                    received[count++] = slot;
+                    yield_();
+                }
+            });
+        filter.spawn([&](embo::yield_t<void()> yield_)
+            {
+                yield_();
+                while (true)
+                {
+                    slot *= 10;
+                    yield_.transfer_to(consumer);
+                }
+            });
+        producer.spawn([&](embo::yield_t<void()> yield_)
+            {
+                yield_();
+                for (int i = 1; i < 4; i++)
+                {
+                    slot = i;
+                    yield_.transfer_to(filter);
+                }
+            });
+
+        while (!producer.exited())
+            producer.reenter();
+
+        TEST_ASSERT_EQUAL(count, 3);
+        TEST_ASSERT_EQUAL(received[0], 10);
+        TEST_ASSERT_EQUAL(received[1], 20);
+        TEST_ASSERT_EQUAL(received[2], 30);
+        TEST_ASSERT(!filter.exited());
+        TEST_ASSERT(!consumer.exited());
+    }
+
+    //if the target exits its value goes to the resumer, the transferring coroutine stays suspended.
+    {
+        embo::coroutine<int()> a{stacks[0]}, b{stacks[1]};
+        TEST_ASSERT_EQUAL(b.spawn([](embo::yield_t<int()> yield_) {yield_(1); return 42;}), 1);
+        TEST_ASSERT_EQUAL(a.spawn([&](embo::yield_t<int()> yield_) {yield_.transfer_to(b); return 7;}), 42);
+        TEST_ASSERT(b.exited());
+        TEST_ASSERT(!a.exited());
+        TEST_ASSERT_EQUAL(a.reenter(), 7);
+        TEST_ASSERT(a.exited());
+    }
+
+    //the pushed value goes to the target, the transferring coroutine gets the one it is reentered with.
+    {
+        embo::coroutine<int(int)> a{stacks[0]}, b{stacks[1]};
+        TEST_ASSERT_EQUAL(b.spawn([](embo::yield_t<int(int)> yield_, int x) {return yield_(x) + 100;}, 0), 0);
+        TEST_ASSERT_EQUAL(a.spawn([&](embo::yield_t<int(int)> yield_, int x) {return yield_.transfer_to(b, x + 1) * 2;}, 5), 106);
+        TEST_ASSERT_EQUAL(a.reenter(3), 6);
+        TEST_ASSERT(a.exited());
+    }
+}
+
+void channel()
+{
+    static std::uint32_t stack_p[512], stack_c[512];
+    embo::round_robin<> sched;
+    embo::channel<std::unique_ptr<int>, 4> ch{sched};
+    embo::task<> producer{stack_p}, consumer{stack_c};
+
+    int sum = 0;
+    int received = 0;
+    std::size_t max_size = 0u;
+
+    sched.spawn(consumer, [&](embo::yield_t<void()> yield_)
+        {
+            std::unique_ptr<int> value;
+            while (ch.recv(yield_, value))
+            {
+                sum += *value;
+                received++;
+                max_size = std::max(max_size, ch.size());
+            }
+        });
+    TEST_ASSERT(consumer.blocked()); //parked on the empty channel
+
+    sched.spawn(producer, [&](embo::yield_t<void()> yield_)
+        {
+            for (int i = 1; i <= 10; i++)
+                TEST_ASSERT(ch.send(yield_, std::unique_ptr<int>(new int(i))));
+            ch.close();
+            TEST_ASSERT(!ch.send(yield_, std::unique_ptr<int>(new int(0))));
+        });
+    TEST_ASSERT(producer.blocked()); //parked on the full channel
+    TEST_ASSERT(ch.full());
+    TEST_ASSERT(!consumer.blocked());
+
+    sched.run();
+    TEST_ASSERT(producer.exited());
+    TEST_ASSERT(consumer.exited());
+    TEST_ASSERT_EQUAL(received, 10);
+    TEST_ASSERT_EQUAL(sum, 55);
+    TEST_ASSERT(max_size <= 3u);
+    TEST_ASSERT(ch.empty());
+
+    //the fast path without tasks
+    embo::channel<int, 2> ch2{sched};
+    int value = 0;
+    TEST_ASSERT(!ch2.try_recv(value));
+    TEST_ASSERT(ch2.try_send(1));
+    TEST_ASSERT(ch2.try_send(2));
+    TEST_ASSERT(!ch2.try_send(3));
+    TEST_ASSERT(ch2.try_recv(value));
+    TEST_ASSERT_EQUAL(value, 1);
+    ch2.close();
+    TEST_ASSERT(!ch2.try_send(4));
+    TEST_ASSERT(ch2.try_recv(value));
+    TEST_ASSERT_EQUAL(value, 2);
+}
+
+//a capacity that doesn't divide the range of size_t, the indices wrap around many times.
+void channel_wrap()
+{
+    embo::round_robin<> sched;
+    embo::channel<int, 3> ch{sched};
+    embo::concurrent_channel<int, 3> cch;
+
+    int next_send = 0, next_recv = 0;
+    bool ordered = true;
+    for (int round = 0; round < 50; round++)
+    {
+        const int n = (round % 3) + 1;
+        for (int i = 0; i < n; i++)
+        {
+            TEST_ASSERT(ch.try_send(next_send));
+            TEST_ASSERT(cch.try_send(next_send));
+            next_send++;
+        }
+        TEST_ASSERT_EQUAL(ch.size(), static_cast<std::size_t>(n));
+        TEST_ASSERT(ch.full() == (n == 3));
+        if (n == 3)
+        {
+            TEST_ASSERT(!ch.try_send(-1));
+            TEST_ASSERT(!cch.try_send(-1));
+        }
+
+        int value = 0;
+        for (int i = 0; i < n; i++)
+        {
+            TEST_ASSERT(ch.try_recv(value));
+            ordered = ordered && (value == next_recv);
+            TEST_ASSERT(cch.try_recv(value));
+            ordered = ordered && (value == next_recv);
+            next_recv++;
+        }
+        TEST_ASSERT(ch.empty());
+        TEST_ASSERT(!ch.try_recv(value));
+        TEST_ASSERT(!cch.try_recv(value));
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT_EQUAL(next_recv, 99);
+}
+
+void batch()
+{
+    static std::uint32_t stack[512];
+    embo::batch_coroutine<std::int32_t> cr{stack};
+
+    auto producer = [](embo::batch_yield<std::int32_t> & yield_)
+        {
+            for (std::int32_t i = 0; i < 90; i++)
+                yield_(i);
+            const std::int32_t tail[10] = {90, 91, 92, 93, 94, 95, 96, 97, 98, 99};
+            yield_.write(tail, 10u);
+        };
+
+    std::int32_t buffer[16];
+    std::int32_t expected = 0;
+    bool ordered = true;
+    std::size_t batches = 0u;
+    std::size_t last = 0u;
+
+    for (auto n = cr.spawn(producer, buffer); ; n = cr.reenter(buffer))
+    {
+        batches++;
+        last = n;
+        for (std::size_t i = 0u; i < n; i++)
+            ordered = ordered && (buffer[i] == expected++);
+        if (cr.exited())
+            break;
+        TEST_ASSERT_EQUAL(n, 16u);
+    }
+
+    TEST_ASSERT(ordered);
+    TEST_ASSERT_EQUAL(expected, 100);
+    TEST_ASSERT_EQUAL(batches, 7u); //6 full batches & the remaining 4 values
+    TEST_ASSERT_EQUAL(last, 4u);
+}
+
+void generator()
+{
+    static std::uint32_t stack[512];
+
+    auto count = [](embo::yield_t<int()> yield_)
+        {
+            for (int i = 1; i < 5; i++)
+                yield_(i);
+            return 5;
+        };
+
+    //the returned value is the last one of the range.
+    {
+        embo::generator<int> gen{stack, count};
+        int expected = 1;
+        for (auto i : gen)
+            TEST_ASSERT_EQUAL(i, expected++);
+        TEST_ASSERT_EQUAL(expected, 6);
+        TEST_ASSERT(gen.done());
+        TEST_ASSERT(gen.exited());
+        TEST_ASSERT(gen.begin() == gen.end());
+    }
+
+    {
+        embo::generator<int> gen{stack, count};
+        TEST_ASSERT_EQUAL(std::accumulate(gen.begin(), gen.end(), 0), 15);
+    }
+
+    {
+        embo::generator<int> gen{stack, count};
+        auto itr = std::find(gen.begin(), gen.end(), 3);
+        TEST_ASSERT(itr != gen.end());
+        TEST_ASSERT_EQUAL(*itr, 3);
+        TEST_ASSERT_EQUAL(*itr++, 3);
+        TEST_ASSERT_EQUAL(*itr, 4);
+        TEST_ASSERT(!gen.exited());
+    }
+
+    //a function that returns right away is a range of one.
+    {
+        embo::generator<std::unique_ptr<int>> gen{stack, [](embo::yield_t<std::unique_ptr<int>()> ) {return std::unique_ptr<int>(new int(42));}};
+        std::size_t n = 0u;
+        for (auto & p : gen)
+        {
+            TEST_ASSERT_EQUAL(*p, 42);
+            n++;
+        }
+        TEST_ASSERT_EQUAL(n, 1u);
+    }
+}
+
+void stream_parser()
+{
+    static std::uint32_t stack[512];
+
+    //length prefixed frames, followed by a line.
+    static const std::uint8_t stream[] = {3, 'a', 'b', 'c', 0, 5, '1', '2', '3', '4', '5', 'h', 'e', 'l', 'l', 'o', '\n'};
+
+    struct result
+    {
+        char frames[3][8];
+        char line[8];
+        int parsed;
+        int copied;
+    };
+
+    auto run = [&](std::size_t chunk_size, result & res)
+        {
+            res = result{};
+            const std::uint8_t * chunk = nullptr;
+            std::size_t chunk_len = 0u;
+            auto inside = [&](embo::byte_view v)
+                {
+                    return (v.data >= chunk) && (v.data + v.size <= chunk + chunk_len);
+                };
+
+            embo::stream_parser<8> parser{stack};
+            parser.spawn([&](embo::byte_reader<8> & in)
+                {
+                    for (int i = 0; i < 3; i++)
+                    {
+                        TEST_ASSERT_EQUAL(in.peek(1u).size, 1u);
+                        const auto length = in.read_byte();
+                        const auto frame = in.read_exact(length);
+                        if (!inside(frame) && !frame.empty())
+                            res.copied++;
+                        std::memcpy(res.frames[i], frame.data, frame.size);
+                        res.parsed++;
+                    }
+                    const auto line = in.read_until('\n');
+                    if (!inside(line))
+                        res.copied++;
+                    std::memcpy(res.line, line.data, line.size - 1u);
+                    res.parsed++;
+                });
+
+            for (std::size_t pos = 0u; pos < sizeof(stream); pos += chunk_size)
+            {
+                chunk = stream + pos;
+                chunk_len = std::min(chunk_size, sizeof(stream) - pos);
+                TEST_ASSERT(parser.push(chunk, chunk_len));
+            }
+            TEST_ASSERT(parser.exited());
+            TEST_ASSERT(!parser.push(stream, 1u));
+        };
+
+    result res;
+    for (std::size_t chunk_size : {1u, 2u, 3u, 7u, 64u})
+    {
+        run(chunk_size, res);
+        TEST_ASSERT_EQUAL(res.parsed, 4);
+        TEST_ASSERT(std::strcmp(res.frames[0], "abc") == 0);
+        TEST_ASSERT(std::strcmp(res.frames[1], "") == 0);
+        TEST_ASSERT(std::strcmp(res.frames[2], "12345") == 0);
+        TEST_ASSERT(std::strcmp(res.line, "hello") == 0);
+    }
+
+    //a single chunk holds every token, so nothing is copied.
+    run(64u, res);
+    TEST_ASSERT_EQUAL(res.copied, 0);
+    //with single bytes everything straddles.
+    run(1u, res);
+    TEST_ASSERT_EQUAL(res.copied, 3);
+
+    //a token beyond the capacity
+    {
+        embo::stream_parser<4> parser{stack};
+        bool overflow = false;
+        parser.spawn([&](embo::byte_reader<4> & in)
+            {
+                overflow = in.read_exact(5u).empty();
+                const auto line = in.read_until('\n');
+                TEST_ASSERT_EQUAL(line.size, 4u);
+                TEST_ASSERT(line[3] != '\n');
+                TEST_ASSERT_EQUAL(in.read_some(16u).size, 3u); //"ef\n"
+            });
+        parser.push("ab", 2u);
+        parser.push("cdef\n", 5u);
+        TEST_ASSERT(overflow);
+        TEST_ASSERT(parser.exited());
+    }
+}
+
+#if defined(__linux__)
+void concurrent_channel()
+{
+    static std::uint32_t stack_p[512], stack_c[512];
+    static embo::concurrent_channel<std::uint32_t, 8> ch;
+    constexpr std::uint32_t count = 10000u;
+
+    std::thread producer([]
+        {
+            embo::coroutine<void()> cr{stack_p};
+            cr.spawn([](embo::yield_t<void()> yield_)
+                {
+                    for (std::uint32_t i = 0u; i < count; i++)
+                        ch.send(yield_, i);
+                    ch.close();
+                });
+            while (!cr.exited())
+            {
+                cr.reenter();
+                std::this_thread::yield();
+            }
+        });
+
+    std::uint64_t sum = 0u;
+    bool ordered = true;
+    embo::coroutine<void()> cr{stack_c};
+    cr.spawn([&](embo::yield_t<void()> yield_)
+        {
+            std::uint32_t value, expected = 0u;
+            while (ch.recv(yield_, value))
+            {
+                ordered = ordered && (value == expected++);
+                sum += value;
+            }
+        });
+    while (!cr.exited())
+    {
+        cr.reenter();
+        std::this_thread::yield();
+    }
+    producer.join();
+
+    TEST_ASSERT(ordered);
+    TEST_ASSERT_EQUAL(sum, static_cast<std::uint64_t>(count) * (count - 1u) / 2u);
+}
+#endif
+
+#if defined(__linux__)
+//counts the resident pages of the stack
+template<typename Stack>
+std::size_t resident_pages(const Stack & st)
+{
+    const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const auto begin = (reinterpret_cast<std::uintptr_t>(st.data()) + page - 1u) & ~(page - 1u);
+    const auto end   = reinterpret_cast<std::uintptr_t>(st.data() + st.size()) & ~(page - 1u);
+    const auto pages = (end - begin) / page;
+    static unsigned char vec[1024];
+    if ((pages > sizeof(vec)) || (mincore(reinterpret_cast<void*>(begin), pages * page, vec) != 0))
+        return ~std::size_t();
+
+    std::size_t cnt = 0u;
+    for (std::size_t i = 0u; i < pages; i++)
+        cnt += vec[i] & 1u;
+    return cnt;
+}
+
+void mmap_stack()
+{
+    embo::mmap_stack st{1024u * 1024u};
+    TEST_ASSERT(st);
+    TEST_ASSERT(st.size() * sizeof(std::uint32_t) >= 1024u * 1024u);
+    TEST_ASSERT_EQUAL(resident_pages(st), 0u);
+
+    embo::coroutine<int(int)> cr{st};
+    auto val = cr.spawn([](embo::yield_t<int(int)> yield_)
+        {
+            auto v = yield_(1);
+            return v * 2;
+        });
+    TEST_ASSERT_EQUAL(val, 1);
+
+    //only the touched pages at the top are committed, unless the whole stack got painted.
+#if !defined(EMBO_COROUTINE_PAINT_STACK)
+    const auto pages = resident_pages(st);
+    TEST_ASSERT(pages > 0u);
+    TEST_ASSERT(pages < 4u);
+#endif
+
+    TEST_ASSERT_EQUAL(cr.reenter(21), 42);
+    TEST_ASSERT(cr.exited());
+
+    auto moved = std::move(st);
+    TEST_ASSERT(!st);
+    TEST_ASSERT(moved);
+}
+
+__attribute__((noinline)) void use_stack_deep(std::size_t depth)
+{
+    volatile char buffer[4096];
+    buffer[0] = 0;
+    if (depth > 0u)
+        use_stack_deep(depth - 1u);
+    buffer[sizeof(buffer) - 1u] = 0;
+}
+
+void madvise_recycle()
+{
+    static embo::stack_pool<2, 1024 * 1024, embo::madvise_recycle<>> pool;
+
+    auto run = [](std::size_t depth)
+        {
+            auto st = pool.acquire();
+            embo::coroutine<void(std::size_t)> cr{st};
+            cr.spawn([](embo::yield_t<void(std::size_t)> , std::size_t depth) {use_stack_deep(depth);}, depth);
+            const auto pages = resident_pages(st);
+            st.release();
+            return pages;
+        };
+
+    //a spike of 256KB
+    const auto spike = run(64u);
+    TEST_ASSERT(spike >= 64u);
+
+    auto st = pool.acquire();
+    TEST_ASSERT(resident_pages(st) >= 64u); //the spike is still warm
+    st.release();
+
+    //the warm depth decays with shallow users, until the spike is given back.
+    for (int i = 0; i < 32; i++)
+        run(1u);
+
+#if !defined(EMBO_COROUTINE_PAINT_STACK) //painting commits the whole stack again
+    st = pool.acquire();
+    TEST_ASSERT(resident_pages(st) < 8u);
+#endif
+}
+#endif
+
+#if defined(EMBO_TEST_STACK_OVERFLOW)
+//every level keeps 64 bytes on the stack & adds after the call, so the recursion can't become a loop.
+std::uint32_t recurse(std::uint32_t depth)
+{
+    volatile std::uint32_t frame[16];
+    frame[0] = depth;
+    return (depth == 0u) ? frame[0] : (recurse(depth - 1u) + frame[0]);
+}
+
+/**Deliberate overflow, the binary must fault & never return from it, so it only gets built on request.
+ *
+ * On Cortex-M it needs EMBO_COROUTINE_STACK_LIMIT, the overflow raises a UsageFault (STKOF) on ARMv8-M Mainline
+ * or a MemManage fault on ARMv7-M. On linux the guard page of the mmap_stack raises SIGSEGV.
+ */
+void stack_overflow()
+{
+#if defined(__linux__)
+    embo::mmap_stack stack{4096u};
+#else
+    static std::uint32_t stack[256];
+#endif
+    embo::coroutine<std::uint32_t()> cr{stack};
+    cr.spawn([](embo::yield_t<std::uint32_t()>) {return recurse(100000u);});
+    test_cnt++; //only reached if the overflow went unnoticed
+}
+#endif
+
 int main(int argc, char * argv[])
 {
     empty_plain();
@@ -369,5 +1619,38 @@ int main(int argc, char * argv[])
     pull_64();
     push_pull_32();
     push_pull_64();
+    push_pull_large();
+    push_pull_record();
+    push_pull_float();
+    pull_move_only();
+    push_move_only();
+    fpu_pull();
+    inline_push_pull();
+#if defined(__aarch64__)
+    push_pull_128();
+#endif
+    push_pull_hfa();
+    round_robin();
+    priority_scheduler();
+    timer_wheel();
+    timer_wheel_idle();
+    stack_pool();
+    stack_high_water();
+    shared_stack();
+    fork_relocate();
+    transfer_to();
+    channel();
+    channel_wrap();
+    batch();
+    generator();
+    stream_parser();
+#if defined(__linux__)
+    concurrent_channel();
+    mmap_stack();
+    madvise_recycle();
+#endif
+#if defined(EMBO_TEST_STACK_OVERFLOW)
+    stack_overflow();
+#endif
     return TEST_REPORT();
 }